@@ -51,7 +51,8 @@ BleTeleinfo bleTeleinfo(bleTransceiver);
  **************************************************************************/
 
 void application_setup(void){
-	Serial.begin(1200);
+	/** historic mode baudrate first - BleTeleinfo switches to standard mode baudrate if needed */
+	Serial.begin(Teleinfo::HISTORIC_BAUDRATE);
 
 	/** Transceiver must be initialized before other application peripherals */
 	bleTransceiver.init(as8_bleName);
@@ -84,4 +85,6 @@ void application_loop(void){
   MemoryWatcher::checkRAMHistory();
   MemoryWatcher::paintStackNow();
   EventManager::applicationTick(LOOP_PERIOD_MS);
+  /** process teleinfo bytes on RX interrupt, sleep otherwise */
+  bleTeleinfo.sleep();
 }
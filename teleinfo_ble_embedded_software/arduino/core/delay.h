@@ -9,6 +9,8 @@ extern "C" {
 
 extern uint32_t millis( void );
 extern uint32_t micros( void );
+extern uint64_t millis64( void );
+extern uint64_t micros64( void );
 extern void delay( uint32_t ms ) ;
 extern void delayMicroseconds( uint32_t us );
 
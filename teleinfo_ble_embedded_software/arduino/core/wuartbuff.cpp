@@ -11,6 +11,8 @@ Buffer::Buffer( void )
 	memset(RX_buff, 0, SERIAL_BUFFER_MAX_SIZE);
 	rx_Head = 0;
 	rx_Tail = 0;
+	rx_Overruns = 0;
+	rx_Errors = 0;
 }
 /**********************************************************************
 name :
@@ -25,6 +27,10 @@ void Buffer::store_char( uint8_t c)
 		RX_buff[rx_Head] = c;
 		rx_Head = i;
 	}
+	else
+	{
+		rx_Overruns++;
+	}
 }
 
 
@@ -14,6 +14,10 @@ class Buffer
 		uint8_t RX_buff[SERIAL_BUFFER_MAX_SIZE];
 		uint8_t rx_Head;
 		uint8_t rx_Tail;
+		/* bytes dropped because buffer was full */
+		uint32_t rx_Overruns;
+		/* bytes dropped on UART error - framing, parity, hardware overrun */
+		uint32_t rx_Errors;
 	
 	public:
 		Buffer(void);
@@ -125,7 +125,10 @@ void UARTClass::irq_handler()
 		dat = UART0_ReadRXDate();
 		
 		if( UART0_CheckRXError() )
+		{
+			rx_buffer->rx_Errors++;
 			return;
+		}
 			
 		rx_buffer->store_char( dat );	
 	}
@@ -140,6 +143,31 @@ void UARTClass::irq_attach( uart_callback_t UART_CallBackFunc )
 {
     UART_CallBack = UART_CallBackFunc;
 }
+/**********************************************************************
+name :
+function : number of received bytes dropped because rx buffer was full
+**********************************************************************/
+uint32_t UARTClass::getRxOverruns( void )
+{
+	return rx_buffer->rx_Overruns;
+}
+/**********************************************************************
+name :
+function : number of received bytes dropped on UART error
+**********************************************************************/
+uint32_t UARTClass::getRxErrors( void )
+{
+	return rx_buffer->rx_Errors;
+}
+/**********************************************************************
+name :
+function :
+**********************************************************************/
+void UARTClass::resetRxErrors( void )
+{
+	rx_buffer->rx_Overruns = 0;
+	rx_buffer->rx_Errors = 0;
+}
 
 
 
@@ -29,6 +29,10 @@ class UARTClass : public HardwareSerial
 		void irq_handler( void );
 		
         void irq_attach( uart_callback_t UART_CallBackFunc );
+
+		uint32_t getRxOverruns( void );
+		uint32_t getRxErrors( void );
+		void resetRxErrors( void );
         
 #if defined __GNUC__ /* GCC CS3 */
 		using Print::write ; // pull in write(str) and write(buf, size) from Print
@@ -0,0 +1,172 @@
+/******************************************************************************
+ * @file    ble_index_encoder.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    18 juin 2016
+ *
+ * @brief Energy indexes compression for BLE
+ *
+ * Project : teleinfo_ble
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "ble_index_encoder.h"
+#include <delay.h>
+#include <string.h>
+
+/*************************************
+ * Private functions
+ *************************************/
+
+/** small deltas of both signs give small unsigned values */
+static uint32_t zigzag(uint32_t arg_u32_newValue, uint32_t arg_u32_oldValue)
+{
+	int32_t loc_s32_delta = (int32_t)(arg_u32_newValue - arg_u32_oldValue);
+	return ((uint32_t) loc_s32_delta << 1) ^ (uint32_t)(loc_s32_delta >> 31);
+}
+
+/** @return number of bytes of value encoded as varint - 7 bits per byte */
+static uint8_t varintLength(uint32_t arg_u32_value)
+{
+	uint8_t loc_u8_length = 1;
+	while(arg_u32_value >= 0x80)
+	{
+		arg_u32_value >>= 7;
+		loc_u8_length++;
+	}
+	return loc_u8_length;
+}
+
+/** least significant group first, MSB set on all bytes but last */
+static uint8_t writeVarint(uint8_t arg_au8_dest[], uint32_t arg_u32_value)
+{
+	uint8_t loc_u8_length = 0;
+	while(arg_u32_value >= 0x80)
+	{
+		arg_au8_dest[loc_u8_length++] = (uint8_t)(arg_u32_value | 0x80);
+		arg_u32_value >>= 7;
+	}
+	arg_au8_dest[loc_u8_length++] = (uint8_t) arg_u32_value;
+	return loc_u8_length;
+}
+
+/*************************************
+ * Method definitions
+ *************************************/
+BleIndexEncoder::BleIndexEncoder(void) :
+	_u16_keyframeMask(0),
+	_u16_encodedMask(0),
+	_u8_seq(0),
+	_u32_lastKeyframeMs(0)
+{
+	memset(_au32_values, 0, sizeof(_au32_values));
+	memset(_au32_sentValues, 0, sizeof(_au32_sentValues));
+}
+
+void BleIndexEncoder::update(const TeleinfoFrame& arg_frame)
+{
+	for(uint8_t loc_u8_index = 0; loc_u8_index < NB_ENERGY_INDEXES; loc_u8_index++)
+	{
+		_au32_values[loc_u8_index] = teleinfoEnergyIndex(arg_frame, loc_u8_index);
+		if(_au32_sentValues[loc_u8_index] == 0 && _au32_values[loc_u8_index] != 0)
+		{
+			_u16_keyframeMask |= (1 << loc_u8_index);
+		}
+	}
+
+	if(millis() - _u32_lastKeyframeMs >= KEYFRAME_PERIOD_MS)
+	{
+		requestKeyframe();
+	}
+}
+
+void BleIndexEncoder::requestKeyframe(void)
+{
+	_u16_keyframeMask = (1 << NB_ENERGY_INDEXES) - 1;
+	_u32_lastKeyframeMs = millis();
+}
+
+uint8_t BleIndexEncoder::encode(uint8_t arg_au8_record[], uint8_t arg_u8_maxLength)
+{
+	uint8_t loc_u8_length = HEADER_LENGTH;
+	uint16_t loc_u16_mask = 0;
+
+	/** indexes not received are not sent */
+	for(uint8_t loc_u8_index = 0; loc_u8_index < NB_ENERGY_INDEXES; loc_u8_index++)
+	{
+		if(_au32_values[loc_u8_index] == 0)
+		{
+			_u16_keyframeMask &= ~(1 << loc_u8_index);
+		}
+	}
+
+	for(uint8_t loc_u8_index = 0; loc_u8_index < NB_ENERGY_INDEXES; loc_u8_index++)
+	{
+		uint16_t loc_u16_bit = (1 << loc_u8_index);
+
+		if(_u16_keyframeMask)
+		{
+			if((_u16_keyframeMask & loc_u16_bit) && loc_u8_length + sizeof(uint32_t) <= arg_u8_maxLength)
+			{
+				arg_au8_record[loc_u8_length++] = (uint8_t)((_au32_values[loc_u8_index] >> 24) & 0xFF);
+				arg_au8_record[loc_u8_length++] = (uint8_t)((_au32_values[loc_u8_index] >> 16) & 0xFF);
+				arg_au8_record[loc_u8_length++] = (uint8_t)((_au32_values[loc_u8_index] >> 8) & 0xFF);
+				arg_au8_record[loc_u8_length++] = (uint8_t)(_au32_values[loc_u8_index] & 0xFF);
+				loc_u16_mask |= loc_u16_bit;
+			}
+		}
+		else if(_au32_values[loc_u8_index] != _au32_sentValues[loc_u8_index])
+		{
+			uint32_t loc_u32_delta = zigzag(_au32_values[loc_u8_index], _au32_sentValues[loc_u8_index]);
+			if(loc_u8_length + varintLength(loc_u32_delta) <= arg_u8_maxLength)
+			{
+				loc_u8_length += writeVarint(&arg_au8_record[loc_u8_length], loc_u32_delta);
+				loc_u16_mask |= loc_u16_bit;
+			}
+		}
+	}
+
+	_u16_encodedMask = loc_u16_mask;
+	if(loc_u16_mask == 0)
+	{
+		return 0;
+	}
+
+	if(_u16_keyframeMask)
+	{
+		loc_u16_mask |= KEYFRAME_FLAG;
+	}
+	arg_au8_record[0] = _u8_seq;
+	arg_au8_record[1] = (uint8_t)((loc_u16_mask >> 8) & 0xFF);
+	arg_au8_record[2] = (uint8_t)(loc_u16_mask & 0xFF);
+	return loc_u8_length;
+}
+
+void BleIndexEncoder::onRecordSent(bool arg_b_sent)
+{
+	/** record not sent : deltas base unchanged, nothing lost */
+	if(!arg_b_sent || _u16_encodedMask == 0)
+	{
+		return;
+	}
+
+	for(uint8_t loc_u8_index = 0; loc_u8_index < NB_ENERGY_INDEXES; loc_u8_index++)
+	{
+		if(_u16_encodedMask & (1 << loc_u8_index))
+		{
+			_au32_sentValues[loc_u8_index] = _au32_values[loc_u8_index];
+		}
+	}
+	_u16_keyframeMask &= ~_u16_encodedMask;
+	_u16_encodedMask = 0;
+	_u8_seq++;
+}
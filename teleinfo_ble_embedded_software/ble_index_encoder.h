@@ -0,0 +1,92 @@
+/******************************************************************************
+ * @file    ble_index_encoder.h
+ * @author  Rémi Pincent - INRIA
+ * @date    18 juin 2016
+ *
+ * @brief Energy indexes compression for BLE : absolute keyframes, then zigzag
+ * varint deltas against values last handed to BLE stack
+ *
+ * Project : teleinfo_ble
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef BLE_INDEX_ENCODER_H_
+#define BLE_INDEX_ENCODER_H_
+
+/**************************************************************************
+ * Include Files
+ **************************************************************************/
+#include <stdint.h>
+#include "teleinfo_frame.h"
+#include "teleinfo_aggregator.h"
+
+/**
+ * Encoded record : [sequence][presence bits - 16 bits big endian][values].
+ * Presence bit n set when EEnergyIndex n present. In keyframes
+ * (KEYFRAME_FLAG set), values are big endian uint32, otherwise zigzag varint
+ * deltas. Sequence only incremented on records handed to BLE stack, a gap
+ * means a record has been lost : deltas are no more valid until next keyframe
+ */
+class BleIndexEncoder
+{
+public:
+	static const uint16_t KEYFRAME_FLAG = 0x8000;
+	static const uint8_t HEADER_LENGTH = 3;
+	/** all indexes sent as absolute values at least this often */
+	static const uint32_t KEYFRAME_PERIOD_MS = 15 * 60 * 1000;
+
+private:
+	/** last values received */
+	uint32_t _au32_values[NB_ENERGY_INDEXES];
+	/** last values handed to BLE stack - gateway deltas base */
+	uint32_t _au32_sentValues[NB_ENERGY_INDEXES];
+	/** indexes to send as absolute values */
+	uint16_t _u16_keyframeMask;
+	/** presence bits of last encoded record */
+	uint16_t _u16_encodedMask;
+	uint8_t _u8_seq;
+	uint32_t _u32_lastKeyframeMs;
+
+public:
+	BleIndexEncoder(void);
+	~BleIndexEncoder(void){};
+
+	/**
+	 * Update indexes values - a keyframe is requested for indexes
+	 * received for the first time or when KEYFRAME_PERIOD_MS elapsed
+	 */
+	void update(const TeleinfoFrame& arg_frame);
+
+	/**
+	 * Send all indexes as absolute values in next records
+	 */
+	void requestKeyframe(void);
+
+	/**
+	 * Encode next record : keyframe if requested, deltas of changed indexes
+	 * otherwise
+	 * @param arg_au8_record
+	 * @param arg_u8_maxLength record max length - indexes not fitting are
+	 * sent in next record
+	 * @return record length, 0 if nothing to send
+	 */
+	uint8_t encode(uint8_t arg_au8_record[], uint8_t arg_u8_maxLength);
+
+	/**
+	 * Must be called after each encode(), before update()
+	 * @param arg_b_sent true if record handed to BLE stack
+	 */
+	void onRecordSent(bool arg_b_sent);
+};
+
+#endif /* BLE_INDEX_ENCODER_H_ */
@@ -0,0 +1,108 @@
+/******************************************************************************
+ * @file    ble_notification_queue.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    18 juin 2016
+ *
+ * @brief Static outbound BLE notifications queue
+ *
+ * Project : teleinfo_ble
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "ble_notification_queue.h"
+#include <string.h>
+#include "logger.h"
+
+BleNotificationQueue::BleNotificationQueue(BLETransceiver& arg_bleTransceiver) :
+	_p_bleTransceiver(&arg_bleTransceiver),
+	_u8_nbNotifications(0)
+{
+	resetStats();
+}
+
+bool BleNotificationQueue::push(uint8_t arg_u8_key, uint8_t arg_u8_length, const uint8_t arg_au8_data[])
+{
+	Notification* loc_p_notification = NULL;
+
+	ASSERT(arg_u8_length <= MAX_NOTIFICATION_LENGTH);
+
+	for(uint8_t loc_u8_index = 0; loc_u8_index < _u8_nbNotifications; loc_u8_index++)
+	{
+		if(_notifications[loc_u8_index]._u8_key == arg_u8_key)
+		{
+			loc_p_notification = &_notifications[loc_u8_index];
+			_stats._u32_nbCoalesced++;
+			break;
+		}
+	}
+
+	if(loc_p_notification == NULL)
+	{
+		if(_u8_nbNotifications == MAX_NOTIFICATIONS)
+		{
+			_stats._u32_nbDropped++;
+			return false;
+		}
+		loc_p_notification = &_notifications[_u8_nbNotifications++];
+		loc_p_notification->_u8_key = arg_u8_key;
+		if(_u8_nbNotifications > _stats._u8_maxDepth)
+		{
+			_stats._u8_maxDepth = _u8_nbNotifications;
+		}
+	}
+
+	loc_p_notification->_u8_length = arg_u8_length;
+	memcpy(loc_p_notification->_au8_data, arg_au8_data, arg_u8_length);
+	_stats._u32_nbQueued++;
+
+	flush();
+	return true;
+}
+
+void BleNotificationQueue::flush(void)
+{
+	uint8_t loc_u8_nbSent = 0;
+
+	while(loc_u8_nbSent < _u8_nbNotifications)
+	{
+		uint8_t loc_u8_length = _notifications[loc_u8_nbSent]._u8_length;
+		if(_p_bleTransceiver->send(loc_u8_length, _notifications[loc_u8_nbSent]._au8_data) < BLETransceiver::NO_ERROR)
+		{
+			break;
+		}
+		loc_u8_nbSent++;
+	}
+
+	if(loc_u8_nbSent != 0)
+	{
+		_u8_nbNotifications -= loc_u8_nbSent;
+		memmove(&_notifications[0], &_notifications[loc_u8_nbSent], _u8_nbNotifications * sizeof(Notification));
+	}
+}
+
+bool BleNotificationQueue::contains(uint8_t arg_u8_key) const
+{
+	for(uint8_t loc_u8_index = 0; loc_u8_index < _u8_nbNotifications; loc_u8_index++)
+	{
+		if(_notifications[loc_u8_index]._u8_key == arg_u8_key)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void BleNotificationQueue::resetStats(void)
+{
+	memset(&_stats, 0, sizeof(_stats));
+}
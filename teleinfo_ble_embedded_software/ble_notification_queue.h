@@ -0,0 +1,101 @@
+/******************************************************************************
+ * @file    ble_notification_queue.h
+ * @author  Rémi Pincent - INRIA
+ * @date    18 juin 2016
+ *
+ * @brief Static outbound BLE notifications queue. Notifications are keyed : a
+ * notification replaces a pending one with same key so that latest value wins
+ * when BLE stack buffers are full
+ *
+ * Project : teleinfo_ble
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef BLE_NOTIFICATION_QUEUE_H_
+#define BLE_NOTIFICATION_QUEUE_H_
+
+/**************************************************************************
+ * Include Files
+ **************************************************************************/
+#include <stdint.h>
+#include "ac_ble_transceiver.h"
+
+class BleNotificationQueue
+{
+public:
+	/**
+	 * keys pending at the same time : a full stats dump (8 parts) and its
+	 * ACK, a FRAME_RECORD, 3 AGGREGATE windows, plus a few ACKs - 22 bytes
+	 * of RAM per entry
+	 */
+	static const uint8_t MAX_NOTIFICATIONS = 16;
+	static const uint8_t MAX_NOTIFICATION_LENGTH = 20;
+
+	/** queue counters since start or last resetStats() */
+	struct Stats{
+		uint32_t _u32_nbQueued;
+		/** pending notifications replaced by a newer one */
+		uint32_t _u32_nbCoalesced;
+		/** notifications dropped on full queue */
+		uint32_t _u32_nbDropped;
+		uint8_t _u8_maxDepth;
+	};
+
+private:
+	struct Notification{
+		uint8_t _u8_key;
+		uint8_t _u8_length;
+		uint8_t _au8_data[MAX_NOTIFICATION_LENGTH];
+	};
+
+	BLETransceiver* _p_bleTransceiver;
+	/** pending notifications in push order */
+	Notification _notifications[MAX_NOTIFICATIONS];
+	uint8_t _u8_nbNotifications;
+	Stats _stats;
+
+public:
+	BleNotificationQueue(BLETransceiver& arg_bleTransceiver);
+	~BleNotificationQueue(void){};
+
+	/**
+	 * Queue notification then send pending ones. A pending notification with
+	 * same key is replaced, keeping its position
+	 * @param arg_u8_key
+	 * @param arg_u8_length at most MAX_NOTIFICATION_LENGTH
+	 * @param arg_au8_data
+	 * @return false if dropped because queue full - only counted in Stats,
+	 * no log since logs share teleinfo UART
+	 */
+	bool push(uint8_t arg_u8_key, uint8_t arg_u8_length, const uint8_t arg_au8_data[]);
+
+	/**
+	 * Send pending notifications in order until BLE stack refuses one
+	 */
+	void flush(void);
+
+	/**
+	 * @return true if a notification with given key is pending
+	 */
+	bool contains(uint8_t arg_u8_key) const;
+
+	/**
+	 * Drop pending notifications
+	 */
+	void clear(void){_u8_nbNotifications = 0;};
+
+	const Stats& getStats(void) const {return _stats;};
+	void resetStats(void);
+};
+
+#endif /* BLE_NOTIFICATION_QUEUE_H_ */
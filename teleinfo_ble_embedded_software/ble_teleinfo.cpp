@@ -20,14 +20,178 @@
  * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
  *****************************************************************************/
 #include <ble_teleinfo.h>
+#include <stddef.h>
+#include <string.h>
 #include "logger.h"
 
+/** write arg_u8_nbBytes lowest bytes of value, big endian */
+static uint8_t writeBigEndian(uint8_t arg_au8_dest[], uint32_t arg_u32_value, uint8_t arg_u8_nbBytes)
+{
+	for(uint8_t loc_u8_index = 0; loc_u8_index < arg_u8_nbBytes; loc_u8_index++)
+	{
+		arg_au8_dest[loc_u8_index] = (uint8_t)((arg_u32_value >> (8 * (arg_u8_nbBytes - 1 - loc_u8_index))) & 0xFF);
+	}
+	return arg_u8_nbBytes;
+}
+
+/** read arg_u8_nbBytes big endian bytes */
+static uint32_t readBigEndian(const uint8_t arg_au8_src[], uint8_t arg_u8_nbBytes)
+{
+	uint32_t loc_u32_value = 0;
+
+	for(uint8_t loc_u8_index = 0; loc_u8_index < arg_u8_nbBytes; loc_u8_index++)
+	{
+		loc_u32_value = (loc_u32_value << 8) | arg_au8_src[loc_u8_index];
+	}
+	return loc_u32_value;
+}
+
+/** BleNotificationQueue key : notification type, then window or part index */
+static uint8_t notificationKey(uint8_t arg_u8_type, uint8_t arg_u8_index)
+{
+	return (uint8_t)((arg_u8_type << 4) | (arg_u8_index & 0x0F));
+}
+
+/** field sent in connection snapshot */
+struct SnapshotField{
+	ETeleinfoField _e_field;
+	uint16_t _u16_offset;
+	/** storage size for numbers, max length for strings */
+	uint8_t _u8_size;
+	bool _b_string;
+	/** numbers : 1, or NB_PHASES for per phase values */
+	uint8_t _u8_nbValues;
+};
+
+#define SNAPSHOT_NUMBER(field, member) {field, (uint16_t) offsetof(TeleinfoFrame, member), sizeof(TeleinfoFrame::member), false, 1}
+#define SNAPSHOT_STRING(field, member) {field, (uint16_t) offsetof(TeleinfoFrame, member), sizeof(TeleinfoFrame::member) - 1, true, 1}
+#define SNAPSHOT_PHASES(field, member) {field, (uint16_t)(offsetof(TeleinfoFrame, _phases) + offsetof(TeleinfoPhase, member)), \
+		sizeof(TeleinfoPhase::member), false, TeleinfoFrame::NB_PHASES}
+
+static const SnapshotField SNAPSHOT_FIELDS[] =
+{
+	SNAPSHOT_STRING(ADCO_FIELD, _as8_hubAddr),
+	SNAPSHOT_NUMBER(OPTARIF_FIELD, _u8_optTar),
+	SNAPSHOT_NUMBER(ISOUSC_FIELD, _u16_souscInt),
+	SNAPSHOT_NUMBER(BASE_FIELD, _u32_baseIndex),
+	SNAPSHOT_NUMBER(HCHC_FIELD, _u32_hcIndex),
+	SNAPSHOT_NUMBER(HCHP_FIELD, _u32_hpIndex),
+	SNAPSHOT_NUMBER(EJPHN_FIELD, _u32_ejpHNIndex),
+	SNAPSHOT_NUMBER(EJPHPM_FIELD, _u32_ejpHPMIndex),
+	SNAPSHOT_NUMBER(BBRHCJB_FIELD, _u32_bbrHCJBIndex),
+	SNAPSHOT_NUMBER(BBRHPJB_FIELD, _u32_bbrHPJBIndex),
+	SNAPSHOT_NUMBER(BBRHCJW_FIELD, _u32_bbrHCJWIndex),
+	SNAPSHOT_NUMBER(BBRHPJW_FIELD, _u32_bbrHPJWIndex),
+	SNAPSHOT_NUMBER(BBRHCJR_FIELD, _u32_bbrHCJRIndex),
+	SNAPSHOT_NUMBER(BBRHPJR_FIELD, _u32_bbrHPJRIndex),
+	SNAPSHOT_NUMBER(PEJP_FIELD, _u8_ejpMess),
+	SNAPSHOT_NUMBER(GAZ_FIELD, _u32_gazIndex),
+	SNAPSHOT_NUMBER(PTEC_FIELD, _u8_currTar),
+	SNAPSHOT_NUMBER(DEMAIN_FIELD, _u8_tomorrowColor),
+	SNAPSHOT_STRING(MOTDETAT_FIELD, _as8_modEtat),
+	SNAPSHOT_NUMBER(IINST_FIELD, _u16_instInt),
+	SNAPSHOT_NUMBER(IMAX_FIELD, _u16_maxInt),
+	SNAPSHOT_NUMBER(PAPP_FIELD, _u32_appPower),
+	SNAPSHOT_NUMBER(HHPHC_FIELD, _s8_hhphc),
+	SNAPSHOT_PHASES(PHASE_IINST_FIELD, _u16_instInt),
+	SNAPSHOT_PHASES(PHASE_IMAX_FIELD, _u16_maxInt),
+	SNAPSHOT_PHASES(ADIR_FIELD, _u16_overInt),
+	SNAPSHOT_NUMBER(PMAX_FIELD, _u32_maxPower),
+	SNAPSHOT_NUMBER(PPOT_FIELD, _u8_potentials),
+	SNAPSHOT_STRING(NGTF_FIELD, _as8_tariffName),
+	SNAPSHOT_STRING(LTARF_FIELD, _as8_tariffLabel),
+	SNAPSHOT_NUMBER(NTARF_FIELD, _u8_tariffIndex),
+	SNAPSHOT_NUMBER(PREF_FIELD, _u8_refPower),
+	SNAPSHOT_NUMBER(URMS1_FIELD, _u16_rmsVoltage),
+	SNAPSHOT_NUMBER(STGE_FIELD, _u32_status),
+};
+
+static const uint8_t NB_SNAPSHOT_FIELDS = sizeof(SNAPSHOT_FIELDS) / sizeof(SNAPSHOT_FIELDS[0]);
+
+/**
+ * Write snapshot entry
+ * @param arg_b_truncate true to truncate strings longer than available space
+ * @return entry length, 0 if it does not fit
+ */
+static uint8_t writeSnapshotEntry(const SnapshotField& arg_field, const TeleinfoFrame& arg_frame, uint32_t arg_u32_ageMs,
+		uint8_t arg_au8_dest[], uint8_t arg_u8_maxLength, bool arg_b_truncate)
+{
+	const uint8_t* loc_p_u8_value = ((const uint8_t*) &arg_frame) + arg_field._u16_offset;
+	uint32_t loc_u32_ageS = arg_u32_ageMs / 1000;
+	uint8_t loc_u8_length = 3;
+	uint8_t loc_u8_valueLength;
+
+	if(arg_field._b_string)
+	{
+		loc_u8_valueLength = strnlen((const char*) loc_p_u8_value, arg_field._u8_size);
+		while(loc_u8_valueLength > 0 && loc_p_u8_value[loc_u8_valueLength - 1] == ' ')
+		{
+			loc_u8_valueLength--;
+		}
+		if(loc_u8_length + 1 + loc_u8_valueLength > arg_u8_maxLength)
+		{
+			if(!arg_b_truncate || loc_u8_length + 1 >= arg_u8_maxLength)
+			{
+				return 0;
+			}
+			loc_u8_valueLength = arg_u8_maxLength - loc_u8_length - 1;
+		}
+		arg_au8_dest[loc_u8_length++] = loc_u8_valueLength;
+		memcpy(&arg_au8_dest[loc_u8_length], loc_p_u8_value, loc_u8_valueLength);
+		loc_u8_length += loc_u8_valueLength;
+	}
+	else
+	{
+		if(loc_u8_length + arg_field._u8_size * arg_field._u8_nbValues > arg_u8_maxLength)
+		{
+			return 0;
+		}
+		for(uint8_t loc_u8_index = 0; loc_u8_index < arg_field._u8_nbValues; loc_u8_index++)
+		{
+			uint32_t loc_u32_value = 0;
+			/** little endian storage, per phase values one TeleinfoPhase apart */
+			memcpy(&loc_u32_value, loc_p_u8_value + loc_u8_index * sizeof(TeleinfoPhase), arg_field._u8_size);
+			loc_u8_length += writeBigEndian(&arg_au8_dest[loc_u8_length], loc_u32_value, arg_field._u8_size);
+		}
+	}
+
+	arg_au8_dest[0] = (uint8_t) arg_field._e_field;
+	writeBigEndian(&arg_au8_dest[1], (loc_u32_ageS > 0xFFFF) ? 0xFFFF : loc_u32_ageS, 2);
+	return loc_u8_length;
+}
+
+/** aggregation windows - s */
+static const uint32_t AGGREGATE_WINDOWS_S[] = {10, 60, 15 * 60};
+
 BleTeleinfo::BleTeleinfo(BLETransceiver& arg_p_bleTransceiver) : _p_bleTransceiver(&arg_p_bleTransceiver),
 _timer(this),
-_teleinfo(&Serial)
+_teleinfo(&Serial),
+_teleinfoTask(Serial, _teleinfo),
+_queue(arg_p_bleTransceiver),
+_filter(*this),
+_aggregator(*this, AGGREGATE_WINDOWS_S, sizeof(AGGREGATE_WINDOWS_S) / sizeof(AGGREGATE_WINDOWS_S[0])),
+_rawCapture(MAX_NOTIFICATION_LENGTH - 1),
+_b_rawMode(false),
+_u8_recordSeq(0),
+_pendingRecordMask(0),
+_u32_lastIndexRecordMs(0),
+_u8_recordFields(0),
+_u16_periodMs(DEFAULT_PERIOD_MS),
+_u8_ackIndex(0),
+_b_snapshotPending(false),
+_u8_snapshotField(0),
+_u8_snapshotPart(0),
+_u32_baudrate(Teleinfo::HISTORIC_BAUDRATE),
+_u32_lastNbValidGroups(0),
+_u32_lastValidGroupMs(0)
 
 {
-	_teleinfo.registerListener(*this);
+	_filter.setFieldFilter(PAPP_FIELD, APP_POWER_DEADBAND_VA, APP_POWER_DEADBAND_PER_MILLE, MIN_SEND_INTERVAL_MS, REFRESH_PERIOD_MS);
+	_filter.setFieldFilter(IINST_FIELD, INST_INT_DEADBAND_A, 0, MIN_SEND_INTERVAL_MS, REFRESH_PERIOD_MS);
+	/** listeners notified in registration order : real power estimated from a frame before it is recorded */
+	_teleinfo.registerListener(_powerEstimator, TeleinfoPowerEstimator::ESTIMATED_FIELDS);
+	_teleinfo.registerListener(_aggregator, TeleinfoAggregator::AGGREGATED_FIELDS);
+	setRecordFields(DEFAULT_RECORD_FIELDS);
 	_p_bleTransceiver->registerListener(this);
 };
 
@@ -37,101 +201,469 @@ BleTeleinfo::~BleTeleinfo(void)
 
 void BleTeleinfo::start(void)
 {
-	_timer.notifyAfter(2000);
+	_teleinfoTask.start(LOW_POWER_MODE);
+	_u32_lastValidGroupMs = millis();
+	_timer.notifyAfter(_u16_periodMs);
 }
 
-void BleTeleinfo::hubAddrChanged(char* arg_hubAddr){LOG_INFO_LN("hubAddr = %s", arg_hubAddr);};
+void BleTeleinfo::onFrame(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask)
+{
+	if(arg_changedMask & teleinfoFieldMask(ADCO_FIELD)){LOG_INFO_LN("hubAddr = %s", arg_frame._as8_hubAddr);}
+	if(arg_changedMask & teleinfoFieldMask(OPTARIF_FIELD)){LOG_INFO_LN("optTar = %d", arg_frame._u8_optTar);}
+	if(arg_changedMask & teleinfoFieldMask(ISOUSC_FIELD)){LOG_INFO_LN("souscInt = %dA", arg_frame._u16_souscInt);}
+
+	if(!_p_bleTransceiver->isConnected())
+	{
+		return;
+	}
 
-void BleTeleinfo::optTarChanged(EOptTar arg_e_optTar){LOG_INFO_LN("optTar = %d", arg_e_optTar);};
+	sendFrameRecord(arg_frame, arg_changedMask);
+}
 
-void BleTeleinfo::baseIndexChanged(uint32_t arg_u32_baseIndex){LOG_INFO_LN("baseIndex = %dWh", arg_u32_baseIndex);};
+void BleTeleinfo::sendFrameRecord(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask)
+{
+	uint8_t loc_u8_key = notificationKey(FRAME_RECORD, 0);
+	uint8_t loc_au8_dataToSend[MAX_NOTIFICATION_LENGTH] = {(uint8_t) FRAME_RECORD, FRAME_RECORD_VERSION};
+	uint8_t loc_u8_length = 3;
+	uint8_t loc_u8_presence = 0;
+	uint32_t loc_u32_realPower = _powerEstimator.getRealPower();
+	uint8_t loc_u8_recordSeq = _u8_recordSeq + 1;
 
-void BleTeleinfo::hcIndexChanged(uint32_t arg_u32_hcIndex){LOG_INFO_LN("hcIndex = %dWh", arg_u32_hcIndex);};
+	/**
+	 * Record still queued : replaced by a record with its fields and changed
+	 * ones, latest values, same sequence number
+	 */
+	if(_queue.contains(loc_u8_key))
+	{
+		arg_changedMask |= _pendingRecordMask;
+		loc_u8_recordSeq = _u8_recordSeq;
+	}
+	loc_au8_dataToSend[2] = loc_u8_recordSeq;
 
-void BleTeleinfo::hpIndexChanged(uint32_t arg_u32_hpIndex){LOG_INFO_LN("hpIndex = %dWh", arg_u32_hpIndex);};
+	loc_u8_length += writeBigEndian(&loc_au8_dataToSend[loc_u8_length], millis(), sizeof(uint32_t));
+	/** presence bits written once values packed */
+	loc_u8_length++;
 
-void BleTeleinfo::ejpHMIChanged(uint32_t arg_u32_ejpHMI){LOG_INFO_LN("ejpHMI = %d", arg_u32_ejpHMI);};
+	if((_u8_recordFields & RECORD_IINST) && (arg_changedMask & teleinfoFieldMask(IINST_FIELD)))
+	{
+		loc_u8_presence |= RECORD_IINST;
+		loc_u8_length += writeBigEndian(&loc_au8_dataToSend[loc_u8_length], arg_frame._u16_instInt, 2);
+	}
+	if(arg_changedMask & teleinfoFieldMask(PAPP_FIELD))
+	{
+		if(_u8_recordFields & RECORD_PAPP)
+		{
+			loc_u8_presence |= RECORD_PAPP;
+			loc_u8_length += writeBigEndian(&loc_au8_dataToSend[loc_u8_length], arg_frame._u32_appPower, 3);
+		}
+		if((_u8_recordFields & RECORD_REAL_POWER) && loc_u32_realPower != TeleinfoPowerEstimator::INVALID_POWER)
+		{
+			loc_u8_presence |= RECORD_REAL_POWER;
+			loc_u8_length += writeBigEndian(&loc_au8_dataToSend[loc_u8_length], loc_u32_realPower, 3);
+		}
+	}
+	if((_u8_recordFields & RECORD_PTEC) && (arg_changedMask & teleinfoFieldMask(PTEC_FIELD)))
+	{
+		loc_u8_presence |= RECORD_PTEC;
+		loc_au8_dataToSend[loc_u8_length++] = arg_frame._u8_currTar;
+	}
+	if((_u8_recordFields & RECORD_ISOUSC) && (arg_changedMask & teleinfoFieldMask(ISOUSC_FIELD)))
+	{
+		loc_u8_presence |= RECORD_ISOUSC;
+		loc_au8_dataToSend[loc_u8_length++] = (arg_frame._u16_souscInt > 0xFF) ? 0xFF : (uint8_t) arg_frame._u16_souscInt;
+	}
+	if((_u8_recordFields & RECORD_DEMAIN) && (arg_changedMask & teleinfoFieldMask(DEMAIN_FIELD)))
+	{
+		loc_u8_presence |= RECORD_DEMAIN;
+		loc_au8_dataToSend[loc_u8_length++] = arg_frame._u8_tomorrowColor;
+	}
 
-void BleTeleinfo::ejpHPMIChanged(uint32_t arg_u32_ejpHPMI){LOG_INFO_LN("ejpHPMI = %d", arg_u32_ejpHPMI);};
+	/** nothing recorded : sequence number kept for next record */
+	if(loc_u8_presence == 0)
+	{
+		return;
+	}
+	loc_au8_dataToSend[FRAME_RECORD_HEADER_LENGTH - 1] = loc_u8_presence;
+	_u8_recordSeq = loc_u8_recordSeq;
+	_pendingRecordMask = arg_changedMask;
 
-void BleTeleinfo::ejpMessChanged(uint8_t arg_u8_ejpMess){LOG_INFO_LN("ejpMess = %d", arg_u8_ejpMess);};
+	/** dropped record sequence number not reused - gateway sees lost records */
+	_queue.push(loc_u8_key, loc_u8_length, loc_au8_dataToSend);
+}
 
-void BleTeleinfo::gazIndexChanged(uint32_t arg_u32_gazIndex){LOG_INFO_LN("gazIndex = %ddal", arg_u32_gazIndex);};
+/** from TimerListener */
+void BleTeleinfo::timerElapsed(void)
+{
+	/** no TX complete event from BLETransceiver - retry queued notifications periodically */
+	_queue.flush();
+	if(_b_snapshotPending && _p_bleTransceiver->isConnected())
+	{
+		sendSnapshot();
+	}
+	if(_p_bleTransceiver->isConnected() && millis() - _u32_lastIndexRecordMs >= INDEX_RECORD_PERIOD_MS)
+	{
+		_u32_lastIndexRecordMs = millis();
+		sendIndexRecords();
+	}
+	_filter.refresh();
+	_aggregator.poll();
+	detectBaudrate();
+	_timer.notifyAfter(_u16_periodMs);
+};
 
-void BleTeleinfo::currTarChanged(EPTEC arg_e_currTar){LOG_INFO_LN("currTar = %d", arg_e_currTar);};
+void BleTeleinfo::sleep(void)
+{
+	_teleinfoTask.sleep();
+	/**
+	 * Raw chunks drained on each wake up, BLE events included : draining them
+	 * once per timer period is far below teleinfo throughput
+	 */
+	if(_b_rawMode && _p_bleTransceiver->isConnected())
+	{
+		sendRawChunks();
+	}
+}
 
-void BleTeleinfo::modEtatChanged(char* arg_modEtat){LOG_INFO_LN("modEtat = %s", arg_modEtat);};
+void BleTeleinfo::startSnapshot(void)
+{
+	_b_snapshotPending = true;
+	_u8_snapshotField = 0;
+	_u8_snapshotPart = 0;
+	sendSnapshot();
+}
 
-void BleTeleinfo::instIntChanged(uint16_t arg_u16_instInt)
+void BleTeleinfo::sendSnapshot(void)
 {
-	if(_p_bleTransceiver->isConnected())
+	uint8_t loc_au8_dataToSend[MAX_NOTIFICATION_LENGTH] = {(uint8_t) SNAPSHOT};
+	const TeleinfoFrame& loc_frame = _teleinfo.getFrame();
+	TeleinfoFieldMask loc_seenMask = _teleinfo.getSeenFields();
+
+	do
 	{
-		uint8_t loc_u8_length = sizeof(arg_u16_instInt) + 1;
-		uint8_t loc_u8_dataToSend[loc_u8_length] = {(uint8_t) IINST,
-				(uint8_t)((arg_u16_instInt >> 8) & 0xFF),
-				(uint8_t)(arg_u16_instInt & 0xFF)
-		};
-		BLETransceiver::Error loc_e_err = _p_bleTransceiver->send(loc_u8_length, loc_u8_dataToSend);
-		if(loc_e_err < BLETransceiver::NO_ERROR || loc_u8_length < sizeof(arg_u16_instInt) + 1)
+		uint8_t loc_u8_length = 2;
+		uint8_t loc_u8_field = _u8_snapshotField;
+
+		for(; loc_u8_field < NB_SNAPSHOT_FIELDS; loc_u8_field++)
 		{
-			LOG_ERROR("Cannot send iinst - err = %d", loc_e_err);
+			const SnapshotField& loc_field = SNAPSHOT_FIELDS[loc_u8_field];
+			uint8_t loc_u8_entryLength;
+
+			if(!(loc_seenMask & teleinfoFieldMask(loc_field._e_field)))
+			{
+				continue;
+			}
+			loc_u8_entryLength = writeSnapshotEntry(loc_field, loc_frame, _teleinfo.getFieldAge(loc_field._e_field),
+					&loc_au8_dataToSend[loc_u8_length], MAX_NOTIFICATION_LENGTH - loc_u8_length, loc_u8_length == 2);
+			if(loc_u8_entryLength == 0)
+			{
+				break;
+			}
+			loc_u8_length += loc_u8_entryLength;
 		}
-	}
-};
 
-void BleTeleinfo::maxIntChanged(uint16_t arg_u16_maxInt)
+		/** last part sent even if empty : gateway knows snapshot is complete */
+		loc_au8_dataToSend[1] = _u8_snapshotPart | ((loc_u8_field == NB_SNAPSHOT_FIELDS) ? SNAPSHOT_LAST_PART : 0);
+		if(_p_bleTransceiver->send(loc_u8_length, loc_au8_dataToSend) < BLETransceiver::NO_ERROR)
+		{
+			return;
+		}
+		_u8_snapshotField = loc_u8_field;
+		_u8_snapshotPart++;
+	}while(_u8_snapshotField < NB_SNAPSHOT_FIELDS);
+
+	_b_snapshotPending = false;
+}
+
+void BleTeleinfo::sendIndexRecords(void)
 {
-};
+	uint8_t loc_au8_dataToSend[MAX_NOTIFICATION_LENGTH] = {(uint8_t) INDEX_RECORD};
+	uint8_t loc_u8_length;
+	bool loc_b_sent = true;
 
-void BleTeleinfo::souscIntChanged(uint16_t arg_u16_souscInt){LOG_INFO_LN("souscInt = %dA", arg_u16_souscInt);};
+	_indexEncoder.update(_teleinfo.getFrame());
+	while(loc_b_sent && (loc_u8_length = _indexEncoder.encode(&loc_au8_dataToSend[1], MAX_NOTIFICATION_LENGTH - 1)) != 0)
+	{
+		loc_u8_length++;
+		loc_b_sent = (_p_bleTransceiver->send(loc_u8_length, loc_au8_dataToSend) >= BLETransceiver::NO_ERROR);
+		_indexEncoder.onRecordSent(loc_b_sent);
+	}
+}
 
-void BleTeleinfo::appPowerChanged(uint32_t arg_u32_appPower)
+void BleTeleinfo::sendRawChunks(void)
 {
-	if(_p_bleTransceiver->isConnected())
+	uint8_t loc_au8_dataToSend[MAX_NOTIFICATION_LENGTH];
+	uint8_t loc_u8_length;
+
+	loc_au8_dataToSend[0] = (uint8_t) RAW_FRAME;
+	while((loc_u8_length = _rawCapture.peekChunk(&loc_au8_dataToSend[1])) != 0)
 	{
-		uint8_t loc_u8_length = sizeof(arg_u32_appPower) + 1;
-		uint8_t loc_u8_dataToSend[loc_u8_length] = {(uint8_t) APP_POWER,
-				(uint8_t)((arg_u32_appPower >> 24) & 0xFF),
-				(uint8_t)((arg_u32_appPower >> 16) & 0xFF),
-				(uint8_t)((arg_u32_appPower >> 8) & 0xFF),
-				(uint8_t)(arg_u32_appPower & 0xFF)
-		};
-		BLETransceiver::Error loc_e_err = _p_bleTransceiver->send(loc_u8_length, loc_u8_dataToSend);
-		if(loc_e_err < BLETransceiver::NO_ERROR || loc_u8_length < sizeof(arg_u32_appPower) + 1)
+		loc_u8_length++;
+		/** chunk kept for next period when BLE buffers full */
+		if(_p_bleTransceiver->send(loc_u8_length, loc_au8_dataToSend) < BLETransceiver::NO_ERROR)
 		{
-			LOG_ERROR("Cannot send apparent power - err = %d", loc_e_err);
+			return;
 		}
+		_rawCapture.releaseChunk();
+	}
+}
+
+void BleTeleinfo::detectBaudrate(void)
+{
+	if(_teleinfo.getNbValidGroups() != _u32_lastNbValidGroups)
+	{
+		_u32_lastNbValidGroups = _teleinfo.getNbValidGroups();
+		_u32_lastValidGroupMs = millis();
+		return;
 	}
-};
 
-void BleTeleinfo::hhphcChanged(char arg_s8_hhphc){LOG_INFO_LN("hhphc = %c", arg_s8_hhphc);};
+	if(millis() - _u32_lastValidGroupMs < BAUDRATE_DETECT_TIMEOUT_MS)
+	{
+		return;
+	}
 
-/** from TimerListener */
-void BleTeleinfo::timerElapsed(void)
+	/** logs are sent on same Serial - they follow baudrate switch */
+	_u32_lastValidGroupMs = millis();
+	_u32_baudrate = (_u32_baudrate == Teleinfo::HISTORIC_BAUDRATE) ? Teleinfo::STANDARD_BAUDRATE : Teleinfo::HISTORIC_BAUDRATE;
+	Serial.begin(_u32_baudrate);
+	_teleinfo.resetParser();
+	LOG_INFO_LN("No valid teleinfo group - switch to %l bauds", _u32_baudrate);
+}
+
+void BleTeleinfo::onAggregate(const TeleinfoAggregate& arg_aggregate)
 {
-	/** read teleinfo periodically */
+	LOG_DEBUG_LN("window %d : papp %l/%l/%l VA", arg_aggregate._u8_window, arg_aggregate._appPower._u32_min,
+			arg_aggregate._appPower._u32_mean, arg_aggregate._appPower._u32_max);
+
 	if(_p_bleTransceiver->isConnected())
 	{
-		_teleinfo.readFrame(20000);
+		sendAggregate(arg_aggregate);
 	}
-	_timer.notifyAfter(2000);
-};
+}
 
-/** from TimerListener */
+void BleTeleinfo::sendAggregate(const TeleinfoAggregate& arg_aggregate)
+{
+	uint32_t loc_u32_energy = arg_aggregate.totalEnergyWh();
+	uint8_t loc_u8_length = 2 + 3 * 3 + 3 * 2 + 2;
+	uint8_t loc_u8_dataToSend[loc_u8_length] = {(uint8_t) AGGREGATE,
+			arg_aggregate._u8_window,
+			(uint8_t)((arg_aggregate._appPower._u32_min >> 16) & 0xFF),
+			(uint8_t)((arg_aggregate._appPower._u32_min >> 8) & 0xFF),
+			(uint8_t)(arg_aggregate._appPower._u32_min & 0xFF),
+			(uint8_t)((arg_aggregate._appPower._u32_mean >> 16) & 0xFF),
+			(uint8_t)((arg_aggregate._appPower._u32_mean >> 8) & 0xFF),
+			(uint8_t)(arg_aggregate._appPower._u32_mean & 0xFF),
+			(uint8_t)((arg_aggregate._appPower._u32_max >> 16) & 0xFF),
+			(uint8_t)((arg_aggregate._appPower._u32_max >> 8) & 0xFF),
+			(uint8_t)(arg_aggregate._appPower._u32_max & 0xFF),
+			(uint8_t)((arg_aggregate._instInt._u32_min >> 8) & 0xFF),
+			(uint8_t)(arg_aggregate._instInt._u32_min & 0xFF),
+			(uint8_t)((arg_aggregate._instInt._u32_mean >> 8) & 0xFF),
+			(uint8_t)(arg_aggregate._instInt._u32_mean & 0xFF),
+			(uint8_t)((arg_aggregate._instInt._u32_max >> 8) & 0xFF),
+			(uint8_t)(arg_aggregate._instInt._u32_max & 0xFF),
+			(uint8_t)(((loc_u32_energy > 0xFFFF ? 0xFFFF : loc_u32_energy) >> 8) & 0xFF),
+			(uint8_t)((loc_u32_energy > 0xFFFF ? 0xFFFF : loc_u32_energy) & 0xFF)
+	};
+	_queue.push(notificationKey(AGGREGATE, arg_aggregate._u8_window), loc_u8_length, loc_u8_dataToSend);
+}
+
+void BleTeleinfo::sendStats(void)
+{
+	const TeleinfoStats& loc_stats = _teleinfo.getStats();
+	TeleinfoTask::PowerStats loc_powerStats = _teleinfoTask.getPowerStats();
+
+	const uint32_t loc_au32_frameStats[] = {loc_stats._u32_nbFrames, loc_stats._u32_nbPartialFrames,
+			loc_stats._u32_nbGroups, loc_stats._u32_nbUnhandledGroups};
+	const uint32_t loc_au32_errorStats[] = {loc_stats._u32_nbCRCErrors, loc_stats._u32_nbLengthErrors,
+			loc_stats._u32_nbValueErrors, loc_stats._u32_nbReadErrors};
+	const uint32_t loc_au32_linkStats[] = {loc_stats._u32_nbReadTimeouts, Serial.getRxOverruns(), Serial.getRxErrors()};
+	const uint32_t loc_au32_gapStats[] = {loc_stats._frameGapMs._u32_min, loc_stats._frameGapMs.avg(), loc_stats._frameGapMs._u32_max};
+	const uint32_t loc_au32_parseStats[] = {loc_stats._frameParseUs._u32_min, loc_stats._frameParseUs.avg(), loc_stats._frameParseUs._u32_max};
+	const uint32_t loc_au32_powerStats[] = {loc_powerStats._u32_nbWakeUps, loc_powerStats._u32_awakeMs, loc_powerStats._u32_elapsedMs,
+			_teleinfoTask.getNbBudgetExhausted()};
+	const BleNotificationQueue::Stats& loc_queueStats = _queue.getStats();
+	const uint32_t loc_au32_queueStats[] = {loc_queueStats._u32_nbQueued, loc_queueStats._u32_nbCoalesced,
+			loc_queueStats._u32_nbDropped, loc_queueStats._u8_maxDepth};
+	const uint32_t loc_au32_rawStats[] = {_rawCapture.getNbDroppedFrames()};
+
+	sendStatsPart(FRAME_STATS, loc_au32_frameStats, sizeof(loc_au32_frameStats) / sizeof(uint32_t));
+	sendStatsPart(ERROR_STATS, loc_au32_errorStats, sizeof(loc_au32_errorStats) / sizeof(uint32_t));
+	sendStatsPart(LINK_STATS, loc_au32_linkStats, sizeof(loc_au32_linkStats) / sizeof(uint32_t));
+	sendStatsPart(GAP_STATS, loc_au32_gapStats, sizeof(loc_au32_gapStats) / sizeof(uint32_t));
+	sendStatsPart(PARSE_STATS, loc_au32_parseStats, sizeof(loc_au32_parseStats) / sizeof(uint32_t));
+	sendStatsPart(POWER_STATS, loc_au32_powerStats, sizeof(loc_au32_powerStats) / sizeof(uint32_t));
+	sendStatsPart(QUEUE_STATS, loc_au32_queueStats, sizeof(loc_au32_queueStats) / sizeof(uint32_t));
+	sendStatsPart(RAW_STATS, loc_au32_rawStats, sizeof(loc_au32_rawStats) / sizeof(uint32_t));
+}
+
+void BleTeleinfo::sendStatsPart(StatsPart arg_e_part, const uint32_t arg_au32_values[], uint8_t arg_u8_nbValues)
+{
+	/** 20 bytes max in a BLE notification */
+	uint8_t loc_au8_dataToSend[2 + 4 * 4] = {(uint8_t) STATS, (uint8_t) arg_e_part};
+	uint8_t loc_u8_length = 2;
+
+	for(uint8_t loc_u8_index = 0; loc_u8_index < arg_u8_nbValues && loc_u8_length + 4 <= (int) sizeof(loc_au8_dataToSend); loc_u8_index++)
+	{
+		loc_au8_dataToSend[loc_u8_length++] = (uint8_t)((arg_au32_values[loc_u8_index] >> 24) & 0xFF);
+		loc_au8_dataToSend[loc_u8_length++] = (uint8_t)((arg_au32_values[loc_u8_index] >> 16) & 0xFF);
+		loc_au8_dataToSend[loc_u8_length++] = (uint8_t)((arg_au32_values[loc_u8_index] >> 8) & 0xFF);
+		loc_au8_dataToSend[loc_u8_length++] = (uint8_t)(arg_au32_values[loc_u8_index] & 0xFF);
+	}
+
+	_queue.push(notificationKey(STATS, arg_e_part), loc_u8_length, loc_au8_dataToSend);
+}
+
+void BleTeleinfo::resetStats(void)
+{
+	_teleinfo.resetStats();
+	Serial.resetRxErrors();
+	_teleinfoTask.resetPowerStats();
+	_queue.resetStats();
+	_rawCapture.resetStats();
+}
+
+void BleTeleinfo::setRecordFields(uint8_t arg_u8_recordFields)
+{
+	/** ADCO and OPTARIF always logged */
+	TeleinfoFieldMask loc_interestMask = teleinfoFieldMask(ADCO_FIELD) | teleinfoFieldMask(OPTARIF_FIELD);
+
+	if(arg_u8_recordFields & RECORD_IINST){loc_interestMask |= teleinfoFieldMask(IINST_FIELD);}
+	/** real power sent on PAPP changes */
+	if(arg_u8_recordFields & (RECORD_PAPP | RECORD_REAL_POWER)){loc_interestMask |= teleinfoFieldMask(PAPP_FIELD);}
+	if(arg_u8_recordFields & RECORD_PTEC){loc_interestMask |= teleinfoFieldMask(PTEC_FIELD);}
+	if(arg_u8_recordFields & RECORD_ISOUSC){loc_interestMask |= teleinfoFieldMask(ISOUSC_FIELD);}
+	if(arg_u8_recordFields & RECORD_DEMAIN){loc_interestMask |= teleinfoFieldMask(DEMAIN_FIELD);}
+
+	_u8_recordFields = arg_u8_recordFields;
+	_teleinfo.unRegisterListener(_filter);
+	_teleinfo.registerListener(_filter, loc_interestMask);
+}
+
+void BleTeleinfo::sendAck(AckStatus arg_e_status, uint8_t arg_u8_dataLength, const uint8_t arg_au8_data[])
+{
+	uint8_t loc_au8_dataToSend[MAX_NOTIFICATION_LENGTH] = {(uint8_t) ACK, (uint8_t) arg_e_status};
+	uint8_t loc_u8_length = (arg_u8_dataLength > MAX_NOTIFICATION_LENGTH - 2) ? MAX_NOTIFICATION_LENGTH - 2 : arg_u8_dataLength;
+
+	memcpy(&loc_au8_dataToSend[2], arg_au8_data, loc_u8_length);
+	/** different key for each ACK : gateway gets a result for every command */
+	_queue.push(notificationKey(ACK, _u8_ackIndex++), loc_u8_length + 2, loc_au8_dataToSend);
+}
+
+BleTeleinfo::AckStatus BleTeleinfo::handleCommand(uint8_t arg_u8_dataLength, const uint8_t arg_au8_data[])
+{
+	switch(arg_au8_data[0])
+	{
+	case DUMP_STATS :
+		sendStats();
+		return ACK_OK;
+	case RESET_STATS :
+		resetStats();
+		return ACK_OK;
+	case SET_RAW_MODE :
+		if(arg_u8_dataLength != 2)
+		{
+			return ACK_BAD_LENGTH;
+		}
+		_b_rawMode = (arg_au8_data[1] != 0);
+		_rawCapture.reset();
+		_teleinfoTask.setRawCapture(_b_rawMode ? &_rawCapture : NULL);
+		LOG_INFO_LN("raw mode %d", _b_rawMode);
+		return ACK_OK;
+	case REQUEST_KEYFRAME :
+		_indexEncoder.requestKeyframe();
+		/** sent on next period */
+		return ACK_OK;
+	case REQUEST_SNAPSHOT :
+		startSnapshot();
+		return ACK_OK;
+	case SET_RECORD_FIELDS :
+		if(arg_u8_dataLength != 2)
+		{
+			return ACK_BAD_LENGTH;
+		}
+		if(arg_au8_data[1] & ~DEFAULT_RECORD_FIELDS)
+		{
+			return ACK_BAD_VALUE;
+		}
+		setRecordFields(arg_au8_data[1]);
+		LOG_INFO_LN("record fields 0x%x", _u8_recordFields);
+		return ACK_OK;
+	case SET_DEADBAND :
+		if(arg_u8_dataLength != 2 + 4 * 2)
+		{
+			return ACK_BAD_LENGTH;
+		}
+		if(arg_au8_data[1] >= NB_TELEINFO_FIELDS
+				|| !_filter.setFieldFilter((ETeleinfoField) arg_au8_data[1], readBigEndian(&arg_au8_data[2], 2),
+						readBigEndian(&arg_au8_data[4], 2), readBigEndian(&arg_au8_data[6], 2) * 1000,
+						readBigEndian(&arg_au8_data[8], 2) * 1000))
+		{
+			return ACK_BAD_VALUE;
+		}
+		LOG_INFO_LN("field %d filter updated", arg_au8_data[1]);
+		return ACK_OK;
+	case SET_AGGREGATE_WINDOW :
+		if(arg_u8_dataLength != 2 + 4)
+		{
+			return ACK_BAD_LENGTH;
+		}
+		/** duration range checked by aggregator */
+		if(!_aggregator.setWindowDuration(arg_au8_data[1], readBigEndian(&arg_au8_data[2], 4)))
+		{
+			return ACK_BAD_VALUE;
+		}
+		LOG_INFO_LN("window %d updated", arg_au8_data[1]);
+		return ACK_OK;
+	case SET_PERIOD :
+	{
+		uint16_t loc_u16_periodMs;
+		if(arg_u8_dataLength != 1 + 2)
+		{
+			return ACK_BAD_LENGTH;
+		}
+		loc_u16_periodMs = (uint16_t) readBigEndian(&arg_au8_data[1], 2);
+		if(loc_u16_periodMs < MIN_PERIOD_MS || loc_u16_periodMs > MAX_PERIOD_MS)
+		{
+			return ACK_BAD_VALUE;
+		}
+		/** applied from next period */
+		_u16_periodMs = loc_u16_periodMs;
+		LOG_INFO_LN("period %dms", _u16_periodMs);
+		return ACK_OK;
+	}
+	default :
+		LOG_ERROR("Command %d not handled", arg_au8_data[0]);
+		return ACK_UNKNOWN_COMMAND;
+	}
+}
+
+/** from IBleTransceiverListener */
 void BleTeleinfo::onDataReceived(uint8_t arg_u8_dataLength, uint8_t arg_au8_data[])
 {
+	if(arg_u8_dataLength == 0)
+	{
+		return;
+	}
 
+	sendAck(handleCommand(arg_u8_dataLength, arg_au8_data), arg_u8_dataLength, arg_au8_data);
 };
 
 void BleTeleinfo::onConnection(void)
 {
-
+	_indexEncoder.requestKeyframe();
+	/** notifications may not be enabled yet - resumed on next periods until sent */
+	startSnapshot();
 };
 
 void BleTeleinfo::onDisconnection(void)
 
 {
-
+	_b_rawMode = false;
+	_queue.clear();
+	/** restarted from first part on next connection */
+	_b_snapshotPending = false;
+	_teleinfoTask.setRawCapture(NULL);
+	_rawCapture.reset();
 };
 
 void BleTeleinfo::onRSSIChange(int8_t arg_s8_rssi)
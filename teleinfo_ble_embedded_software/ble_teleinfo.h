@@ -27,53 +27,294 @@
  **************************************************************************/
 #include "ac_ble_transceiver.h"
 #include "teleinfo.h"
+#include "teleinfo_filter.h"
+#include "teleinfo_aggregator.h"
+#include "teleinfo_power.h"
+#include "teleinfo_raw.h"
+#include "teleinfo_task.h"
+#include "ble_index_encoder.h"
+#include "ble_notification_queue.h"
 #include <EventManager.h>
 #include <timer.h>
 
 class BleTeleinfo :     public ITeleinfoListener,
+						public ITeleinfoAggregateListener,
 						public TimerListener,
 						public IBleTransceiverListener
 {
 private :
 	enum TeleinfoType : uint8_t
 	{
+		/** not sent anymore - replaced by FRAME_RECORD */
 		IINST = 0,
-		APP_POWER = 1
+		/** not sent anymore - replaced by FRAME_RECORD */
+		APP_POWER = 1,
+		/** followed by stats part index and up to 4 big endian uint32 values */
+		STATS = 2,
+		/** window summary - refer sendAggregate() */
+		AGGREGATE = 3,
+		/** raw frame chunk - refer TeleinfoRawCapture */
+		RAW_FRAME = 4,
+		/** frame changes - refer sendFrameRecord() */
+		FRAME_RECORD = 5,
+		/** energy indexes - refer BleIndexEncoder */
+		INDEX_RECORD = 6,
+		/** cached state - refer sendSnapshot() */
+		SNAPSHOT = 7,
+		/** command handled - refer sendAck() */
+		ACK = 8
 	};
 
+	/** FRAME_RECORD format version */
+	static const uint8_t FRAME_RECORD_VERSION = 1;
+
+	/** FRAME_RECORD presence bits, values packed in this order */
+	enum RecordField : uint8_t
+	{
+		/** A - 16 bits */
+		RECORD_IINST = 0x01,
+		/** VA - 24 bits */
+		RECORD_PAPP = 0x02,
+		/** W - 24 bits, refer TeleinfoPowerEstimator */
+		RECORD_REAL_POWER = 0x04,
+		/** EPTEC - 8 bits */
+		RECORD_PTEC = 0x08,
+		/** A - 8 bits */
+		RECORD_ISOUSC = 0x10,
+		/** ETempoColor - 8 bits */
+		RECORD_DEMAIN = 0x20
+	};
+
+	/** commands received from gateway */
+	enum BleCommand : uint8_t
+	{
+		DUMP_STATS = 0,
+		RESET_STATS = 1,
+		/** followed by 1 to forward raw frames, 0 to stop */
+		SET_RAW_MODE = 2,
+		/** gateway lost an INDEX_RECORD, send absolute indexes */
+		REQUEST_KEYFRAME = 3,
+		/** send cached state again */
+		REQUEST_SNAPSHOT = 4,
+		/** followed by RecordField bits of fields sent in FRAME_RECORD */
+		SET_RECORD_FIELDS = 5,
+		/**
+		 * followed by ETeleinfoField, absolute deadband - 16 bits, relative
+		 * deadband per mille - 16 bits, min interval s - 16 bits, refresh
+		 * period s - 16 bits, 0 if never. Field must be numeric, all
+		 * settings 0 removes field filter
+		 */
+		SET_DEADBAND = 6,
+		/**
+		 * followed by window index, duration s - 32 bits, from 1 to
+		 * TeleinfoAggregator::MAX_WINDOW_DURATION_S (one day)
+		 */
+		SET_AGGREGATE_WINDOW = 7,
+		/** followed by timer period ms - 16 bits */
+		SET_PERIOD = 8
+	};
+
+	/** ACK status */
+	enum AckStatus : uint8_t
+	{
+		ACK_OK = 0,
+		ACK_UNKNOWN_COMMAND = 1,
+		ACK_BAD_LENGTH = 2,
+		/** command argument out of range, or setting refused */
+		ACK_BAD_VALUE = 3
+	};
+
+	/** stats dump parts */
+	enum StatsPart : uint8_t
+	{
+		FRAME_STATS = 0,
+		ERROR_STATS = 1,
+		LINK_STATS = 2,
+		GAP_STATS = 3,
+		PARSE_STATS = 4,
+		POWER_STATS = 5,
+		QUEUE_STATS = 6,
+		RAW_STATS = 7
+	};
+
+	/** PAPP and IINST changes notified over BLE - jitter filtered to save airtime */
+	static const uint32_t APP_POWER_DEADBAND_VA = 20;
+	static const uint16_t APP_POWER_DEADBAND_PER_MILLE = 20;
+	static const uint32_t INST_INT_DEADBAND_A = 1;
+	static const uint32_t MIN_SEND_INTERVAL_MS = 5000;
+	static const uint32_t REFRESH_PERIOD_MS = 60000;
+
+	/** fields sent in FRAME_RECORD until SET_RECORD_FIELDS received */
+	static const uint8_t DEFAULT_RECORD_FIELDS = RECORD_IINST | RECORD_PAPP | RECORD_REAL_POWER | RECORD_PTEC
+			| RECORD_ISOUSC | RECORD_DEMAIN;
+
+	/** timer period - notifications retried, filter and aggregator polled on each period */
+	static const uint16_t DEFAULT_PERIOD_MS = 2000;
+	static const uint16_t MIN_PERIOD_MS = 200;
+	static const uint16_t MAX_PERIOD_MS = 10000;
+
+	/** device powered by teleinfo - sleep between received bytes */
+	static const bool LOW_POWER_MODE = true;
+
+	/** type, version, sequence number, ms timestamp, presence bits */
+	static const uint8_t FRAME_RECORD_HEADER_LENGTH = 1 + 1 + 1 + 4 + 1;
+
+	/** set in SNAPSHOT part index of last part */
+	static const uint8_t SNAPSHOT_LAST_PART = 0x80;
+
+	/** energy indexes sent at most this often */
+	static const uint32_t INDEX_RECORD_PERIOD_MS = 10000;
+
+	/** BLE notification max length */
+	static const uint8_t MAX_NOTIFICATION_LENGTH = 20;
+	/** time without valid group before trying other mode baudrate - ms. Longer
+	 * than a frame whatever the timer period */
+	static const uint32_t BAUDRATE_DETECT_TIMEOUT_MS = 6000;
+
 private:
 	BLETransceiver* _p_bleTransceiver;
 	Timer _timer;
 	Teleinfo _teleinfo;
+	/** feeds _teleinfo with Serial bytes */
+	TeleinfoTask _teleinfoTask;
+	/** FRAME_RECORD, AGGREGATE and STATS notifications */
+	BleNotificationQueue _queue;
+	/** teleinfo frames go through filter before being sent */
+	TeleinfoFilter _filter;
+	/** 10s, 1min, 15min summaries */
+	TeleinfoAggregator _aggregator;
+	/** real power sent along with PAPP */
+	TeleinfoPowerEstimator _powerEstimator;
+	/** raw frames forwarded when _b_rawMode set - fed by _teleinfoTask. Frame
+	 * buffers (2KB) part of BleTeleinfo even when raw mode is off */
+	TeleinfoRawCapture _rawCapture;
+	bool _b_rawMode;
+	/** sequence number of next FRAME_RECORD */
+	uint8_t _u8_recordSeq;
+	/** fields of FRAME_RECORD still queued */
+	TeleinfoFieldMask _pendingRecordMask;
+	BleIndexEncoder _indexEncoder;
+	uint32_t _u32_lastIndexRecordMs;
+	/** RecordField bits sent in FRAME_RECORD */
+	uint8_t _u8_recordFields;
+	uint16_t _u16_periodMs;
+	/** ACK queue key index - every ACK kept until sent */
+	uint8_t _u8_ackIndex;
+	/** snapshot being sent : next field in snapshot table, next part index */
+	bool _b_snapshotPending;
+	uint8_t _u8_snapshotField;
+	uint8_t _u8_snapshotPart;
+	/** teleinfo baudrate detection */
+	uint32_t _u32_baudrate;
+	uint32_t _u32_lastNbValidGroups;
+	/** last time a new valid group was seen - ms */
+	uint32_t _u32_lastValidGroupMs;
 
 public:
 	BleTeleinfo(BLETransceiver& arg_p_bleTransceiver);
 	~BleTeleinfo(void);
 	void start(void);
 
+	/**
+	 * Sleep until next event in low power mode, then forward captured raw
+	 * frame chunks. Must be called from application loop
+	 */
+	void sleep(void);
+
+	/**
+	 * Record teleinfo bytes for off device replay
+	 * @param arg_p_recorder recorder wrapping Serial, NULL to stop recording
+	 */
+	void setCaptureRecorder(TeleinfoCaptureRecorder* arg_p_recorder){_teleinfoTask.setCaptureRecorder(arg_p_recorder);};
+
 private:
 	/** from ITeleinfoListener */
-	void hubAddrChanged(char* arg_hubAddr);
-	void optTarChanged(EOptTar arg_e_optTar);
-	void baseIndexChanged(uint32_t arg_u32_baseIndex);
-	void hcIndexChanged(uint32_t arg_u32_hcIndex);
-	void hpIndexChanged(uint32_t arg_u32_hpIndex);
-	void ejpHMIChanged(uint32_t arg_u32_ejpHMI);
-	void ejpHPMIChanged(uint32_t arg_u32_ejpHPMI);
-	void ejpMessChanged(uint8_t arg_u8_ejpMess);
-	void gazIndexChanged(uint32_t arg_u32_gazIndex);
-	void currTarChanged(EPTEC arg_e_currTar);
-	void modEtatChanged(char* arg_modEtat);
-	void instIntChanged(uint16_t arg_u16_instInt);
-	void maxIntChanged(uint16_t arg_u16_maxInt);
-	void souscIntChanged(uint16_t arg_u16_souscInt);
-	void appPowerChanged(uint32_t arg_u32_appPower);
-	void hhphcChanged(char arg_s8_hhphc);
+	void onFrame(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask);
+
+	/**
+	 * Send changed fields of a frame in a single notification :
+	 * [FRAME_RECORD][version][sequence][timestamp ms - 32 bits][RecordField
+	 * presence bits][present values in RecordField order] - big endian.
+	 * Real power sent with PAPP once estimated. A record still queued is
+	 * merged with new one
+	 */
+	void sendFrameRecord(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask);
+
+	/**
+	 * Restart snapshot from first field
+	 */
+	void startSnapshot(void);
+
+	/**
+	 * Send every field received so far, with its age, in packed SNAPSHOT
+	 * notifications : [SNAPSHOT][part index | SNAPSHOT_LAST_PART] then
+	 * entries [ETeleinfoField][age s - 16 bits][value]. Numbers are big
+	 * endian, per phase fields give NB_PHASES numbers, strings are
+	 * [length][chars] with trailing spaces removed.
+	 * Resumed on next period when BLE stack refuses a part
+	 */
+	void sendSnapshot(void);
+
+	/**
+	 * Send changed energy indexes as INDEX_RECORD notifications until all sent
+	 * or BLE stack refuses one
+	 */
+	void sendIndexRecords(void);
+
+	/**
+	 * Send chunks of captured raw frame until BLE stack refuses one
+	 */
+	void sendRawChunks(void);
+
+	/** from ITeleinfoAggregateListener */
+	void onAggregate(const TeleinfoAggregate& arg_aggregate);
+
+	/**
+	 * Send window summary : window index, PAPP min mean max on 24 bits, IINST
+	 * min mean max on 16 bits, total energy in Wh on 16 bits - big endian
+	 */
+	void sendAggregate(const TeleinfoAggregate& arg_aggregate);
+
+	/**
+	 * Send teleinfo parser, UART and low power health counters, one packet
+	 * per StatsPart
+	 */
+	void sendStats(void);
+	void sendStatsPart(StatsPart arg_e_part, const uint32_t arg_au32_values[], uint8_t arg_u8_nbValues);
+
+	/**
+	 * Reset teleinfo parser, UART and low power health counters
+	 */
+	void resetStats(void);
+
+	/**
+	 * Apply a command received from gateway
+	 * @return ACK status
+	 */
+	AckStatus handleCommand(uint8_t arg_u8_dataLength, const uint8_t arg_au8_data[]);
+
+	/**
+	 * Register frame changes listener for FRAME_RECORD fields
+	 * @param arg_u8_recordFields RecordField bits
+	 */
+	void setRecordFields(uint8_t arg_u8_recordFields);
+
+	/**
+	 * Send command result : [ACK][AckStatus][received command bytes] -
+	 * command truncated to notification length
+	 */
+	void sendAck(AckStatus arg_e_status, uint8_t arg_u8_dataLength, const uint8_t arg_au8_data[]);
 
 	/** from TimerListener */
 	void timerElapsed(void);
 
-	/** from TimerListener */
+	/**
+	 * Switch Serial between historic and standard teleinfo baudrates when no
+	 * valid group has been received for BAUDRATE_DETECT_TIMEOUT_MS
+	 */
+	void detectBaudrate(void);
+
+	/** from IBleTransceiverListener */
 	void onDataReceived(uint8_t arg_u8_dataLength, uint8_t arg_au8_data[]);
 	void onConnection(void);
 	void onDisconnection(void);
@@ -0,0 +1,34 @@
+/******************************************************************************
+ * @file    arduino_core.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Host build of Arduino core Stream and Print. Core Arduino.h pulls nRF51 headers : its guard is defined and the few definitions Stream and Print need are given here
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define Arduino_h
+#include <delay.h>
+typedef uint8_t boolean;
+typedef uint8_t byte;
+#include <WString.h>
+
+#include <Stream.cpp>
+#include <Print.cpp>
@@ -0,0 +1,53 @@
+/******************************************************************************
+ * @file    bench_crc.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Group checksum benchmarks : checksum is accumulated while group bytes are fed, a whole group is fed
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo.h"
+#include "teleinfo_host_frames.h"
+#include <benchmark/benchmark.h>
+
+/*************************************
+ * Benchmarks
+ *************************************/
+/**
+ * Feed a group again and again in a frame that never ends
+ * @param arg_group LF ... CR
+ */
+static void BM_GroupChecksum(benchmark::State& state, const std::string& arg_group)
+{
+	Teleinfo loc_teleinfo(NULL);
+	const uint8_t loc_u8_startText = 0x02;
+	const uint8_t* loc_au8_group = (const uint8_t*) arg_group.data();
+
+	loc_teleinfo.feed(loc_u8_startText);
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(loc_teleinfo.feed(loc_au8_group, arg_group.size()));
+	}
+	if(loc_teleinfo.getStats()._u32_nbCRCErrors != 0)
+	{
+		state.SkipWithError("checksum errors");
+	}
+	state.SetBytesProcessed(state.iterations() * arg_group.size());
+}
+BENCHMARK_CAPTURE(BM_GroupChecksum, historic, TeleinfoHostFrames::historicGroup("HCHC", "001234567"));
+BENCHMARK_CAPTURE(BM_GroupChecksum, standard, TeleinfoHostFrames::standardGroup("EAST", "001234567"));
+/** meters do not timestamp handled groups : SINSTS timestamped to measure timestamp skipping */
+BENCHMARK_CAPTURE(BM_GroupChecksum, standard_timestamp, TeleinfoHostFrames::standardGroup("SINSTS", "05120", "H170101093000"));
@@ -0,0 +1,71 @@
+/******************************************************************************
+ * @file    bench_decode.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Numeric value decode benchmarks
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo.h"
+#include <benchmark/benchmark.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*************************************
+ * Private definitions
+ *************************************/
+/** index, power and current values as received - not null terminated */
+static const uint8_t INDEX_VALUE[] = {'0', '1', '2', '3', '4', '5', '6', '7', '8'};
+static const uint8_t POWER_VALUE[] = {'0', '2', '5', '0', '0'};
+static const uint8_t CURRENT_VALUE[] = {'0', '1', '2'};
+
+/*************************************
+ * Benchmarks
+ *************************************/
+static void BM_DecodeDecimal(benchmark::State& state, const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen)
+{
+	uint32_t loc_u32_decoded = 0;
+
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(arg_au8_value);
+		benchmark::DoNotOptimize(Teleinfo::decodeDecimal(arg_au8_value, arg_u8_valueLen, &loc_u32_decoded));
+		benchmark::DoNotOptimize(loc_u32_decoded);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_DecodeDecimal, index, INDEX_VALUE, sizeof(INDEX_VALUE));
+BENCHMARK_CAPTURE(BM_DecodeDecimal, power, POWER_VALUE, sizeof(POWER_VALUE));
+BENCHMARK_CAPTURE(BM_DecodeDecimal, current, CURRENT_VALUE, sizeof(CURRENT_VALUE));
+
+/** legacy decode baseline : value null terminated in group buffer then atoi() */
+static void BM_DecodeAtoi(benchmark::State& state, const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen)
+{
+	char loc_as8_value[16] = {0};
+	uint32_t loc_u32_decoded = 0;
+
+	memcpy(loc_as8_value, arg_au8_value, arg_u8_valueLen);
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(loc_as8_value);
+		loc_u32_decoded = (uint32_t) atoi(loc_as8_value);
+		benchmark::DoNotOptimize(loc_u32_decoded);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_CAPTURE(BM_DecodeAtoi, index, INDEX_VALUE, sizeof(INDEX_VALUE));
+BENCHMARK_CAPTURE(BM_DecodeAtoi, power, POWER_VALUE, sizeof(POWER_VALUE));
+BENCHMARK_CAPTURE(BM_DecodeAtoi, current, CURRENT_VALUE, sizeof(CURRENT_VALUE));
@@ -0,0 +1,79 @@
+/******************************************************************************
+ * @file    bench_frame.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Full frame parse benchmarks, on synthetic and recorded frames
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "bench_frame.h"
+#include "teleinfo.h"
+#include "teleinfo_capture.h"
+#include "teleinfo_host_frames.h"
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+
+/*************************************
+ * Private definitions
+ *************************************/
+/** listener keeps frame notification in measured path */
+class FrameCounter : public ITeleinfoListener {
+public:
+	uint32_t _u32_nbFrames;
+	FrameCounter(void) : _u32_nbFrames(0){};
+	void onFrame(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask){_u32_nbFrames++;};
+};
+
+/**
+ * Parse given bytes again and again
+ * @param arg_bytes one or several frames
+ */
+static void BM_Frames(benchmark::State& state, const std::string& arg_bytes)
+{
+	Teleinfo loc_teleinfo(NULL);
+	FrameCounter loc_counter;
+	const uint8_t* loc_au8_bytes = (const uint8_t*) arg_bytes.data();
+
+	loc_teleinfo.registerListener(loc_counter);
+	for(auto _ : state)
+	{
+		benchmark::DoNotOptimize(loc_teleinfo.feed(loc_au8_bytes, arg_bytes.size()));
+	}
+	if(loc_teleinfo.getStats()._u32_nbCRCErrors != 0)
+	{
+		state.SkipWithError("checksum errors");
+	}
+	state.SetBytesProcessed(state.iterations() * arg_bytes.size());
+	state.counters["frames"] = benchmark::Counter(loc_teleinfo.getStats()._u32_nbFrames, benchmark::Counter::kIsRate);
+}
+BENCHMARK_CAPTURE(BM_Frames, historic, TeleinfoHostFrames::historicFrame());
+BENCHMARK_CAPTURE(BM_Frames, standard, TeleinfoHostFrames::standardFrame());
+
+/*************************************
+ * Public functions
+ *************************************/
+bool registerCaptureBenchmark(const char* arg_as8_path)
+{
+	std::vector<uint8_t> loc_capture;
+
+	if(!TeleinfoHostFrames::loadCapture(arg_as8_path, loc_capture) || !TeleinfoCaptureStream(loc_capture.data(), loc_capture.size()).isValid())
+	{
+		fprintf(stderr, "cannot load capture %s\n", arg_as8_path);
+		return false;
+	}
+	benchmark::RegisterBenchmark("BM_Frames/capture", BM_Frames, TeleinfoHostFrames::captureBytes(loc_capture));
+	return true;
+}
@@ -0,0 +1,32 @@
+/******************************************************************************
+ * @file    bench_frame.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Full frame parse benchmarks
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_HOST_BENCHMARK_BENCH_FRAME_H_
+#define TELEINFO_HOST_BENCHMARK_BENCH_FRAME_H_
+
+/**
+ * Register a benchmark parsing bytes recorded in a capture file
+ * @param arg_as8_path TeleinfoCapture file
+ * @return false if capture cannot be loaded
+ */
+bool registerCaptureBenchmark(const char* arg_as8_path);
+
+#endif /* TELEINFO_HOST_BENCHMARK_BENCH_FRAME_H_ */
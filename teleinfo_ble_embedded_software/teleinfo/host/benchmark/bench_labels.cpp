@@ -0,0 +1,136 @@
+/******************************************************************************
+ * @file    bench_labels.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Group label dispatch benchmarks
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo.h"
+#include "teleinfo_labels.h"
+#include <benchmark/benchmark.h>
+#include <string.h>
+
+/*************************************
+ * Private definitions
+ *************************************/
+/** labels of a single phase HC.. frame, in frame order */
+static const char* const HISTORIC_LABELS[] = {"ADCO", "OPTARIF", "ISOUSC", "HCHC", "HCHP", "PTEC", "IINST", "IMAX", "PAPP", "HHPHC", "MOTDETAT"};
+static const size_t NB_HISTORIC_LABELS = sizeof(HISTORIC_LABELS) / sizeof(HISTORIC_LABELS[0]);
+
+/** labels of a Linky frame, handled or not */
+static const char* const STANDARD_LABELS[] = {"ADSC", "VTIC", "DATE", "NGTF", "LTARF", "EAST", "EASF01", "EASF02", "IRMS1", "URMS1",
+		"PREF", "PCOUP", "SINSTS", "SMAXSN", "STGE", "MSG1", "PRM", "RELAIS", "NTARF", "NJOURF"};
+static const size_t NB_STANDARD_LABELS = sizeof(STANDARD_LABELS) / sizeof(STANDARD_LABELS[0]);
+static_assert(NB_STANDARD_LABELS >= NB_HISTORIC_LABELS, "strcmp chain benchmark buffer sized on standard labels");
+
+/** pack labels as received bytes are packed */
+static void packLabels(const char* const arg_aas8_labels[], size_t arg_u32_nbLabels, uint64_t arg_au64_keys[])
+{
+	for(size_t loc_u32_index = 0; loc_u32_index < arg_u32_nbLabels; loc_u32_index++)
+	{
+		arg_au64_keys[loc_u32_index] = TeleinfoLabels::pack(arg_aas8_labels[loc_u32_index]);
+	}
+}
+
+/**
+ * Labels in legacy parseGroup() strcmp() chain order, kept as baseline of
+ * hashed dispatch
+ */
+static const char* const LEGACY_HISTORIC_LABELS[] = {"ADCO", "MOTDETAT", "OPTARIF", "ISOUSC", "IINST", "IMAX", "HCHC", "HCHP",
+		"BASE", "EJPHN", "EJPHPM", "BBRHCJB", "BBRHPJB", "BBRHCJW", "BBRHPJW", "BBRHCJR", "BBRHPJR", "DEMAIN", "GAZ", "PEJP",
+		"PTEC", "PAPP", "HHPHC", "IINST1", "IINST2", "IINST3", "IMAX1", "IMAX2", "IMAX3", "ADIR1", "ADIR2", "ADIR3", "PMAX", "PPOT"};
+static const char* const LEGACY_STANDARD_LABELS[] = {"ADSC", "NGTF", "LTARF", "EAST", "EASF01", "EASF02", "IRMS1", "URMS1",
+		"PREF", "SINSTS", "STGE", "NTARF"};
+
+/**
+ * Legacy dispatch : compare received label with each handled label
+ * @return label index in arg_aas8_handled, arg_u32_nbHandled if not handled
+ */
+static size_t strcmpChain(const char* arg_s8_label, const char* const arg_aas8_handled[], size_t arg_u32_nbHandled)
+{
+	size_t loc_u32_index;
+
+	for(loc_u32_index = 0; loc_u32_index < arg_u32_nbHandled; loc_u32_index++)
+	{
+		if(strcmp(arg_aas8_handled[loc_u32_index], arg_s8_label) == 0)
+		{
+			break;
+		}
+	}
+	return loc_u32_index;
+}
+
+/*************************************
+ * Benchmarks
+ *************************************/
+static void BM_LabelLookupHistoric(benchmark::State& state)
+{
+	uint64_t loc_au64_keys[NB_HISTORIC_LABELS];
+	packLabels(HISTORIC_LABELS, NB_HISTORIC_LABELS, loc_au64_keys);
+
+	for(auto _ : state)
+	{
+		for(size_t loc_u32_index = 0; loc_u32_index < NB_HISTORIC_LABELS; loc_u32_index++)
+		{
+			benchmark::DoNotOptimize(Teleinfo::lookupLabel(loc_au64_keys[loc_u32_index], Teleinfo::TIC_MODE_HISTORIC));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * NB_HISTORIC_LABELS);
+}
+BENCHMARK(BM_LabelLookupHistoric);
+
+static void BM_LabelLookupStandard(benchmark::State& state)
+{
+	uint64_t loc_au64_keys[NB_STANDARD_LABELS];
+	packLabels(STANDARD_LABELS, NB_STANDARD_LABELS, loc_au64_keys);
+
+	for(auto _ : state)
+	{
+		for(size_t loc_u32_index = 0; loc_u32_index < NB_STANDARD_LABELS; loc_u32_index++)
+		{
+			benchmark::DoNotOptimize(Teleinfo::lookupLabel(loc_au64_keys[loc_u32_index], Teleinfo::TIC_MODE_STANDARD));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * NB_STANDARD_LABELS);
+}
+BENCHMARK(BM_LabelLookupStandard);
+
+static void BM_LabelStrcmpChain(benchmark::State& state, const char* const* arg_aas8_labels, size_t arg_u32_nbLabels,
+		const char* const* arg_aas8_handled, size_t arg_u32_nbHandled)
+{
+	/** labels copied as received in parser label buffer - standard frame has the most labels */
+	char loc_aas8_received[NB_STANDARD_LABELS][10];
+
+	for(size_t loc_u32_index = 0; loc_u32_index < arg_u32_nbLabels; loc_u32_index++)
+	{
+		strncpy(loc_aas8_received[loc_u32_index], arg_aas8_labels[loc_u32_index], sizeof(loc_aas8_received[0]));
+	}
+
+	for(auto _ : state)
+	{
+		for(size_t loc_u32_index = 0; loc_u32_index < arg_u32_nbLabels; loc_u32_index++)
+		{
+			benchmark::DoNotOptimize(loc_aas8_received[loc_u32_index]);
+			benchmark::DoNotOptimize(strcmpChain(loc_aas8_received[loc_u32_index], arg_aas8_handled, arg_u32_nbHandled));
+		}
+	}
+	state.SetItemsProcessed(state.iterations() * arg_u32_nbLabels);
+}
+BENCHMARK_CAPTURE(BM_LabelStrcmpChain, historic, HISTORIC_LABELS, NB_HISTORIC_LABELS,
+		LEGACY_HISTORIC_LABELS, sizeof(LEGACY_HISTORIC_LABELS) / sizeof(LEGACY_HISTORIC_LABELS[0]));
+BENCHMARK_CAPTURE(BM_LabelStrcmpChain, standard, STANDARD_LABELS, NB_STANDARD_LABELS,
+		LEGACY_STANDARD_LABELS, sizeof(LEGACY_STANDARD_LABELS) / sizeof(LEGACY_STANDARD_LABELS[0]));
@@ -0,0 +1,43 @@
+/******************************************************************************
+ * @file    teleinfo_benchmark.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo host benchmarks entry point. Set TELEINFO_CAPTURE to a TeleinfoCapture file to also benchmark recorded frames
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "bench_frame.h"
+#include <benchmark/benchmark.h>
+#include <stdlib.h>
+
+int main(int argc, char** argv)
+{
+	const char* loc_as8_capture = getenv("TELEINFO_CAPTURE");
+
+	if(loc_as8_capture != NULL && !registerCaptureBenchmark(loc_as8_capture))
+	{
+		return 1;
+	}
+
+	benchmark::Initialize(&argc, argv);
+	if(benchmark::ReportUnrecognizedArguments(argc, argv))
+	{
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+	return 0;
+}
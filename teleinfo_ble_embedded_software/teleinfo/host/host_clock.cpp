@@ -0,0 +1,92 @@
+/******************************************************************************
+ * @file    host_clock.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Host build clock backing delay.h
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "host_clock.h"
+#include <delay.h>
+#include <time.h>
+
+/*************************************
+ * Private functions
+ *************************************/
+static bool sb_manual = false;
+static uint64_t su64_manualUs = 0;
+
+static uint64_t monotonicUs(void)
+{
+	struct timespec loc_time;
+	clock_gettime(CLOCK_MONOTONIC, &loc_time);
+	return (uint64_t) loc_time.tv_sec * 1000000 + loc_time.tv_nsec / 1000;
+}
+
+/*************************************
+ * Public functions
+ *************************************/
+void hostClockSet(uint64_t arg_u64_us)
+{
+	sb_manual = true;
+	su64_manualUs = arg_u64_us;
+}
+
+void hostClockAdvance(uint64_t arg_u64_us)
+{
+	su64_manualUs += arg_u64_us;
+}
+
+void hostClockRelease(void)
+{
+	sb_manual = false;
+}
+
+uint64_t micros64(void)
+{
+	return sb_manual ? su64_manualUs : monotonicUs();
+}
+
+uint64_t millis64(void)
+{
+	return micros64() / 1000;
+}
+
+uint32_t micros(void)
+{
+	return (uint32_t) micros64();
+}
+
+uint32_t millis(void)
+{
+	return (uint32_t) millis64();
+}
+
+void delay(uint32_t ms)
+{
+	delayMicroseconds(ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us)
+{
+	if(sb_manual)
+	{
+		su64_manualUs += us;
+		return;
+	}
+	uint64_t loc_u64_endUs = monotonicUs() + us;
+	while(monotonicUs() < loc_u64_endUs);
+}
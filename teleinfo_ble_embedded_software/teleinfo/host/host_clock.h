@@ -0,0 +1,45 @@
+/******************************************************************************
+ * @file    host_clock.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Host build clock backing delay.h - monotonic time, or a manual clock tests can drive
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_HOST_HOST_CLOCK_H_
+#define TELEINFO_HOST_HOST_CLOCK_H_
+
+#include <stdint.h>
+
+/**
+ * Stop following monotonic time : millis() and micros() then return given
+ * time until changed
+ * @param arg_u64_us
+ */
+void hostClockSet(uint64_t arg_u64_us);
+
+/**
+ * Advance manual clock
+ * @param arg_u64_us
+ */
+void hostClockAdvance(uint64_t arg_u64_us);
+
+/**
+ * Follow monotonic time again
+ */
+void hostClockRelease(void);
+
+#endif /* TELEINFO_HOST_HOST_CLOCK_H_ */
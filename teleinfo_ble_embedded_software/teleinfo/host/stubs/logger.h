@@ -0,0 +1,47 @@
+/******************************************************************************
+ * @file    logger.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Host build logger - logs disabled unless TELEINFO_HOST_LOG is defined
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef LOGGER_H_
+#define LOGGER_H_
+
+#include <assert.h>
+
+#ifdef TELEINFO_HOST_LOG
+	#include <stdio.h>
+	/** firmware logger %l is a 32 bits value */
+	#define LOG_HOST(msg, arguments...) fprintf(stderr, msg "\n", ## arguments)
+#else
+	#define LOG_HOST(msg, arguments...) ((void) 0)
+#endif
+
+#define LOG_INIT(level)
+#define LOG_INIT_STREAM(level, stream)
+#define ASSERT(expr) assert(expr)
+
+#define LOG_ERROR(msg, arguments...) LOG_HOST(msg, ## arguments)
+#define LOG_INFO(msg, arguments...) LOG_HOST(msg, ## arguments)
+#define LOG_INFO_LN(msg, arguments...) LOG_HOST(msg, ## arguments)
+#define LOG_DEBUG(msg, arguments...) LOG_HOST(msg, ## arguments)
+#define LOG_DEBUG_LN(msg, arguments...) LOG_HOST(msg, ## arguments)
+#define LOG_VERBOSE(msg, arguments...) LOG_HOST(msg, ## arguments)
+#define LOG_VERBOSE_LN(msg, arguments...) LOG_HOST(msg, ## arguments)
+
+#endif /* LOGGER_H_ */
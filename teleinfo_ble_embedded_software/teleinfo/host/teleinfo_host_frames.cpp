@@ -0,0 +1,158 @@
+/******************************************************************************
+ * @file    teleinfo_host_frames.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo groups and frames built for host tests and benchmarks
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_host_frames.h"
+#include "teleinfo_capture.h"
+#include <stdio.h>
+
+/*************************************
+ * Private functions
+ *************************************/
+static const char START_TEXT = 0x02;
+static const char END_TEXT = 0x03;
+
+/** @return value on given number of digits */
+static std::string digits(uint32_t arg_u32_value, uint8_t arg_u8_nbDigits)
+{
+	char loc_as8_value[16];
+	snprintf(loc_as8_value, sizeof(loc_as8_value), "%0*u", arg_u8_nbDigits, arg_u32_value);
+	return loc_as8_value;
+}
+
+/*************************************
+ * Public functions
+ *************************************/
+uint8_t TeleinfoHostFrames::checksum(const std::string& arg_checked)
+{
+	uint8_t loc_u8_sum = 0;
+	for(size_t loc_u32_index = 0; loc_u32_index < arg_checked.size(); loc_u32_index++)
+	{
+		loc_u8_sum += (uint8_t) arg_checked[loc_u32_index];
+	}
+	return (loc_u8_sum & 0x3F) + 0x20;
+}
+
+std::string TeleinfoHostFrames::historicGroup(const std::string& arg_label, const std::string& arg_value)
+{
+	std::string loc_checked = arg_label + " " + arg_value;
+	return "\n" + loc_checked + " " + (char) checksum(loc_checked) + "\r";
+}
+
+std::string TeleinfoHostFrames::standardGroup(const std::string& arg_label, const std::string& arg_value, const std::string& arg_timestamp)
+{
+	std::string loc_checked = arg_label + "\t" + (arg_timestamp.empty() ? "" : arg_timestamp + "\t") + arg_value + "\t";
+	return "\n" + loc_checked + (char) checksum(loc_checked) + "\r";
+}
+
+std::string TeleinfoHostFrames::frame(const std::string& arg_groups)
+{
+	return START_TEXT + arg_groups + END_TEXT;
+}
+
+std::string TeleinfoHostFrames::historicFrame(uint32_t arg_u32_appPower, uint32_t arg_u32_hcIndex)
+{
+	return frame(historicGroup("ADCO", "012345678901")
+			+ historicGroup("OPTARIF", "HC..")
+			+ historicGroup("ISOUSC", "45")
+			+ historicGroup("HCHC", digits(arg_u32_hcIndex, 9))
+			+ historicGroup("HCHP", digits(7654321, 9))
+			+ historicGroup("PTEC", "HP..")
+			+ historicGroup("IINST", digits(arg_u32_appPower / 230, 3))
+			+ historicGroup("IMAX", "090")
+			+ historicGroup("PAPP", digits(arg_u32_appPower, 5))
+			+ historicGroup("HHPHC", "A")
+			+ historicGroup("MOTDETAT", "000000"));
+}
+
+std::string TeleinfoHostFrames::standardFrame(uint32_t arg_u32_appPower, uint32_t arg_u32_totalIndex)
+{
+	return frame(standardGroup("ADSC", "041876097815")
+			+ standardGroup("VTIC", "02")
+			+ standardGroup("DATE", "", "H170101120000")
+			+ standardGroup("NGTF", "      TEMPO     ")
+			+ standardGroup("LTARF", "    HP  BLEU    ")
+			+ standardGroup("EAST", digits(arg_u32_totalIndex, 9))
+			+ standardGroup("EASF01", digits(arg_u32_totalIndex / 3, 9))
+			+ standardGroup("EASF02", digits(arg_u32_totalIndex - arg_u32_totalIndex / 3, 9))
+			+ standardGroup("EASF03", "000000000")
+			+ standardGroup("EASD01", digits(arg_u32_totalIndex, 9))
+			+ standardGroup("IRMS1", digits(arg_u32_appPower / 230, 3))
+			+ standardGroup("URMS1", "231")
+			+ standardGroup("PREF", "09")
+			+ standardGroup("PCOUP", "09")
+			+ standardGroup("SINSTS", digits(arg_u32_appPower, 5))
+			+ standardGroup("SMAXSN", "05120", "H170101093000")
+			+ standardGroup("CCASN", "01200", "H170101113000")
+			+ standardGroup("UMOY1", "230", "H170101115000")
+			+ standardGroup("STGE", "003A0001")
+			+ standardGroup("MSG1", "PAS DE          MESSAGE         ")
+			+ standardGroup("PRM", "12345678901234")
+			+ standardGroup("RELAIS", "000")
+			+ standardGroup("NTARF", "02")
+			+ standardGroup("NJOURF", "00")
+			+ standardGroup("NJOURF+1", "00")
+			+ standardGroup("PJOURF+1", "00004001 06004002 22004001 NONUTILE NONUTILE"));
+}
+
+std::string TeleinfoHostFrames::withParity(const std::string& arg_bytes)
+{
+	std::string loc_bytes(arg_bytes);
+	for(size_t loc_u32_index = 0; loc_u32_index < loc_bytes.size(); loc_u32_index++)
+	{
+		uint8_t loc_u8_byte = (uint8_t) loc_bytes[loc_u32_index] & 0x7F;
+		if(__builtin_parity(loc_u8_byte))
+		{
+			loc_u8_byte |= 0x80;
+		}
+		loc_bytes[loc_u32_index] = (char) loc_u8_byte;
+	}
+	return loc_bytes;
+}
+
+bool TeleinfoHostFrames::loadCapture(const char* arg_path, std::vector<uint8_t>& arg_capture)
+{
+	FILE* loc_p_file = fopen(arg_path, "rb");
+	uint8_t loc_au8_buffer[4096];
+	size_t loc_u32_read;
+
+	if(loc_p_file == NULL)
+	{
+		return false;
+	}
+	arg_capture.clear();
+	while((loc_u32_read = fread(loc_au8_buffer, 1, sizeof(loc_au8_buffer), loc_p_file)) > 0)
+	{
+		arg_capture.insert(arg_capture.end(), loc_au8_buffer, loc_au8_buffer + loc_u32_read);
+	}
+	fclose(loc_p_file);
+	return true;
+}
+
+std::string TeleinfoHostFrames::captureBytes(const std::vector<uint8_t>& arg_capture)
+{
+	std::string loc_bytes;
+	for(size_t loc_u32_offset = TeleinfoCapture::HEADER_LENGTH; loc_u32_offset + TeleinfoCapture::RECORD_LENGTH <= arg_capture.size();
+			loc_u32_offset += TeleinfoCapture::RECORD_LENGTH)
+	{
+		loc_bytes += (char) arg_capture[loc_u32_offset + 4];
+	}
+	return loc_bytes;
+}
@@ -0,0 +1,85 @@
+/******************************************************************************
+ * @file    teleinfo_host_frames.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo groups and frames built for host tests and benchmarks, and capture files loading
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_HOST_TELEINFO_HOST_FRAMES_H_
+#define TELEINFO_HOST_TELEINFO_HOST_FRAMES_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace TeleinfoHostFrames
+{
+	/**
+	 * Group checksum as defined in Enedis-NOI-CPT_54E : sum of bytes, 6 lowest
+	 * bits, + 0x20
+	 * @param arg_checked bytes covered by checksum
+	 */
+	uint8_t checksum(const std::string& arg_checked);
+
+	/**
+	 * @return LF label SPACE value SPACE checksum CR - separator before
+	 * checksum not part of it
+	 */
+	std::string historicGroup(const std::string& arg_label, const std::string& arg_value);
+
+	/**
+	 * @param arg_timestamp empty if group not timestamped
+	 * @return LF label HTAB [timestamp HTAB] value HTAB checksum CR -
+	 * separator before checksum part of it
+	 */
+	std::string standardGroup(const std::string& arg_label, const std::string& arg_value, const std::string& arg_timestamp = "");
+
+	/**
+	 * @return STX groups ETX
+	 */
+	std::string frame(const std::string& arg_groups);
+
+	/**
+	 * @return single phase HC.. option frame
+	 */
+	std::string historicFrame(uint32_t arg_u32_appPower = 2500, uint32_t arg_u32_hcIndex = 1234567);
+
+	/**
+	 * @return single phase Linky frame, including groups not handled by parser
+	 */
+	std::string standardFrame(uint32_t arg_u32_appPower = 2500, uint32_t arg_u32_totalIndex = 1234567);
+
+	/**
+	 * Set parity bit of each byte so that it has even parity, as received on
+	 * a 7E1 line read as 8N1
+	 */
+	std::string withParity(const std::string& arg_bytes);
+
+	/**
+	 * @param arg_path TeleinfoCapture file
+	 * @param arg_capture file content
+	 * @return false if file cannot be read
+	 */
+	bool loadCapture(const char* arg_path, std::vector<uint8_t>& arg_capture);
+
+	/**
+	 * @return recorded bytes of a capture, without arrival times
+	 */
+	std::string captureBytes(const std::vector<uint8_t>& arg_capture);
+}
+
+#endif /* TELEINFO_HOST_TELEINFO_HOST_FRAMES_H_ */
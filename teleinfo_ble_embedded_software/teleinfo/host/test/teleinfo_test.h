@@ -0,0 +1,67 @@
+/******************************************************************************
+ * @file    teleinfo_test.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Minimal host test helpers - a test executable returns non zero when a check fails
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_HOST_TEST_TELEINFO_TEST_H_
+#define TELEINFO_HOST_TEST_TELEINFO_TEST_H_
+
+#include <stdio.h>
+
+/** number of failed checks in test executable */
+extern int gs32_nbFailures;
+
+/** check a condition, test goes on when it fails */
+#define CHECK(expr) do{ \
+		if(!(expr)) \
+		{ \
+			fprintf(stderr, "%s:%d: check failed : %s\n", __FILE__, __LINE__, #expr); \
+			gs32_nbFailures++; \
+		} \
+	}while(0)
+
+/** check integer equality, values printed when it fails */
+#define CHECK_EQUAL(expected, actual) do{ \
+		long long loc_s64_expected = (long long)(expected); \
+		long long loc_s64_actual = (long long)(actual); \
+		if(loc_s64_expected != loc_s64_actual) \
+		{ \
+			fprintf(stderr, "%s:%d: %s : %lld expected, got %lld\n", __FILE__, __LINE__, #actual, loc_s64_expected, loc_s64_actual); \
+			gs32_nbFailures++; \
+		} \
+	}while(0)
+
+/** define test executable failure count, and main() running given tests */
+#define TELEINFO_TEST_MAIN(...) \
+	int gs32_nbFailures = 0; \
+	int main(void) \
+	{ \
+		void (*loc_ap_tests[])(void) = {__VA_ARGS__}; \
+		for(size_t loc_u32_index = 0; loc_u32_index < sizeof(loc_ap_tests) / sizeof(loc_ap_tests[0]); loc_u32_index++) \
+		{ \
+			loc_ap_tests[loc_u32_index](); \
+		} \
+		if(gs32_nbFailures) \
+		{ \
+			fprintf(stderr, "%d check(s) failed\n", gs32_nbFailures); \
+		} \
+		return gs32_nbFailures ? 1 : 0; \
+	}
+
+#endif /* TELEINFO_HOST_TEST_TELEINFO_TEST_H_ */
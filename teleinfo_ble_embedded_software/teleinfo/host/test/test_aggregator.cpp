@@ -0,0 +1,131 @@
+/******************************************************************************
+ * @file    test_aggregator.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Windowed aggregator host tests
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_test.h"
+#include "teleinfo_aggregator.h"
+#include "host_clock.h"
+#include <string.h>
+
+/*************************************
+ * Private definitions
+ *************************************/
+/** records last aggregate */
+class AggregateListener : public ITeleinfoAggregateListener {
+public:
+	uint32_t _u32_nbAggregates;
+	TeleinfoAggregate _last;
+	AggregateListener(void) : _u32_nbAggregates(0){};
+	void onAggregate(const TeleinfoAggregate& arg_aggregate)
+	{
+		_u32_nbAggregates++;
+		_last = arg_aggregate;
+	};
+};
+
+static const uint32_t WINDOWS_S[] = {10};
+
+static void advanceMs(uint32_t arg_u32_ms)
+{
+	hostClockAdvance((uint64_t) arg_u32_ms * 1000);
+}
+
+/*************************************
+ * Tests
+ *************************************/
+static void testStandardEnergy(void)
+{
+	AggregateListener loc_listener;
+	TeleinfoAggregator loc_aggregator(loc_listener, WINDOWS_S, 1);
+	TeleinfoFrame loc_frame;
+
+	/** EAST stored in BASE, EASF01/02 in HCHC/HCHP */
+	memset(&loc_frame, 0, sizeof(loc_frame));
+	loc_frame._u32_baseIndex = 1000000;
+	loc_frame._u32_hcIndex = 400000;
+	loc_frame._u32_hpIndex = 600000;
+	hostClockSet(0);
+	loc_aggregator.onFrame(loc_frame, ALL_TELEINFO_FIELDS);
+
+	advanceMs(5000);
+	loc_frame._u32_baseIndex += 3;
+	loc_frame._u32_hpIndex += 3;
+	loc_aggregator.onFrame(loc_frame, ALL_TELEINFO_FIELDS);
+	advanceMs(5000);
+	loc_aggregator.poll();
+	CHECK_EQUAL(1, loc_listener._u32_nbAggregates);
+	CHECK_EQUAL(3, loc_listener._last._au16_energyWh[BASE_INDEX]);
+	CHECK_EQUAL(3, loc_listener._last._au16_energyWh[HP_INDEX]);
+	CHECK_EQUAL(3, loc_listener._last.totalEnergyWh());
+	hostClockRelease();
+}
+
+static void testHistoricEnergy(void)
+{
+	AggregateListener loc_listener;
+	TeleinfoAggregator loc_aggregator(loc_listener, WINDOWS_S, 1);
+	TeleinfoFrame loc_frame;
+
+	/** HC.. option : energy split on HCHC and HCHP */
+	memset(&loc_frame, 0, sizeof(loc_frame));
+	loc_frame._u32_hcIndex = 400000;
+	loc_frame._u32_hpIndex = 600000;
+	hostClockSet(0);
+	loc_aggregator.onFrame(loc_frame, ALL_TELEINFO_FIELDS);
+
+	advanceMs(5000);
+	loc_frame._u32_hcIndex += 2;
+	loc_frame._u32_hpIndex += 3;
+	loc_aggregator.onFrame(loc_frame, ALL_TELEINFO_FIELDS);
+	advanceMs(5000);
+	loc_aggregator.poll();
+	CHECK_EQUAL(1, loc_listener._u32_nbAggregates);
+	CHECK_EQUAL(5, loc_listener._last.totalEnergyWh());
+	hostClockRelease();
+}
+
+static void testWindowDuration(void)
+{
+	AggregateListener loc_listener;
+	TeleinfoAggregator loc_aggregator(loc_listener, WINDOWS_S, 1);
+	TeleinfoFrame loc_frame;
+
+	memset(&loc_frame, 0, sizeof(loc_frame));
+	hostClockSet(0);
+	loc_aggregator.onFrame(loc_frame, ALL_TELEINFO_FIELDS);
+
+	CHECK(!loc_aggregator.setWindowDuration(1, 60));
+	CHECK(!loc_aggregator.setWindowDuration(0, 0));
+	/** duration x 1000 overflows 32 bits */
+	CHECK(!loc_aggregator.setWindowDuration(0, 4294968));
+	CHECK(!loc_aggregator.setWindowDuration(0, TeleinfoAggregator::MAX_WINDOW_DURATION_S + 1));
+	CHECK(loc_aggregator.setWindowDuration(0, TeleinfoAggregator::MAX_WINDOW_DURATION_S));
+
+	advanceMs(TeleinfoAggregator::MAX_WINDOW_DURATION_S * 1000 - 1);
+	loc_aggregator.poll();
+	CHECK_EQUAL(0, loc_listener._u32_nbAggregates);
+	advanceMs(1);
+	loc_aggregator.poll();
+	CHECK_EQUAL(1, loc_listener._u32_nbAggregates);
+	CHECK_EQUAL(TeleinfoAggregator::MAX_WINDOW_DURATION_S, loc_listener._last._u32_durationS);
+	hostClockRelease();
+}
+
+TELEINFO_TEST_MAIN(testStandardEnergy, testHistoricEnergy, testWindowDuration)
@@ -0,0 +1,172 @@
+/******************************************************************************
+ * @file    test_capture.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Capture record and replay host tests
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_test.h"
+#include "teleinfo.h"
+#include "teleinfo_capture.h"
+#include "teleinfo_host_frames.h"
+#include "host_clock.h"
+
+using namespace TeleinfoHostFrames;
+
+/*************************************
+ * Private definitions
+ *************************************/
+/** one byte time at historic mode baudrate : start, 7 data, parity, stop bits */
+static const uint32_t HISTORIC_BYTE_US = 10 * 1000000 / Teleinfo::HISTORIC_BAUDRATE;
+/** micros() wraps after 2^32 us */
+static const uint64_t MICROS_WRAP_US = 0x100000000ULL;
+
+/** stream reading given bytes */
+class StringStream : public Stream {
+private:
+	std::string _bytes;
+	size_t _u32_offset;
+public:
+	StringStream(const std::string& arg_bytes) : _bytes(arg_bytes), _u32_offset(0){};
+	int available(void){return (int)(_bytes.size() - _u32_offset);};
+	int read(void){return _u32_offset < _bytes.size() ? (uint8_t) _bytes[_u32_offset++] : -1;};
+	int peek(void){return _u32_offset < _bytes.size() ? (uint8_t) _bytes[_u32_offset] : -1;};
+	void flush(void){};
+	size_t write(uint8_t arg_u8_byte){return 0;};
+};
+
+static uint32_t recordDelay(const std::vector<uint8_t>& arg_capture, size_t arg_u32_record)
+{
+	const uint8_t* loc_au8_record = &arg_capture[TeleinfoCapture::HEADER_LENGTH + arg_u32_record * TeleinfoCapture::RECORD_LENGTH];
+	return (uint32_t) loc_au8_record[0] | ((uint32_t) loc_au8_record[1] << 8)
+			| ((uint32_t) loc_au8_record[2] << 16) | ((uint32_t) loc_au8_record[3] << 24);
+}
+
+/**
+ * Record given bytes read at given baudrate pace
+ * @return capture
+ */
+static std::vector<uint8_t> record(const std::string& arg_bytes, uint32_t arg_u32_byteUs, size_t arg_u32_captureSize)
+{
+	std::vector<uint8_t> loc_capture(arg_u32_captureSize);
+	StringStream loc_stream(arg_bytes);
+	TeleinfoCaptureRecorder loc_recorder(loc_stream, loc_capture.data(), loc_capture.size(), Teleinfo::HISTORIC_BAUDRATE);
+
+	while(loc_recorder.available() > 0)
+	{
+		hostClockAdvance(arg_u32_byteUs);
+		loc_recorder.read();
+	}
+	loc_capture.resize(loc_recorder.getCaptureLength());
+	return loc_capture;
+}
+
+/*************************************
+ * Tests
+ *************************************/
+static void testRecordReplay(void)
+{
+	std::string loc_frame = historicFrame();
+	std::vector<uint8_t> loc_capture;
+	TeleinfoReplayReport loc_report;
+	Teleinfo loc_teleinfo(NULL);
+
+	/** recorded across micros() wrap */
+	hostClockSet(MICROS_WRAP_US - 10 * HISTORIC_BYTE_US);
+	loc_capture = record(loc_frame, HISTORIC_BYTE_US, TeleinfoCapture::HEADER_LENGTH + 1000 * TeleinfoCapture::RECORD_LENGTH);
+	CHECK_EQUAL(TeleinfoCapture::HEADER_LENGTH + loc_frame.size() * TeleinfoCapture::RECORD_LENGTH, loc_capture.size());
+	CHECK(captureBytes(loc_capture) == loc_frame);
+	for(size_t loc_u32_record = 0; loc_u32_record < loc_frame.size(); loc_u32_record++)
+	{
+		CHECK_EQUAL(HISTORIC_BYTE_US, recordDelay(loc_capture, loc_u32_record));
+	}
+
+	TeleinfoCaptureStream loc_stream(loc_capture.data(), loc_capture.size());
+	CHECK(loc_stream.isValid());
+	CHECK_EQUAL(Teleinfo::HISTORIC_BAUDRATE, loc_stream.getBaudrate());
+	loc_stream.start(TeleinfoCaptureStream::REPLAY_UNTHROTTLED);
+	replayTeleinfoCapture(loc_teleinfo, loc_stream, loc_report);
+	CHECK_EQUAL(loc_frame.size(), loc_report._u32_nbBytes);
+	CHECK_EQUAL(1, loc_report._u32_nbFrames);
+	CHECK_EQUAL(11, loc_report._u32_nbGroups);
+	CHECK_EQUAL(0, loc_report._u32_nbCRCErrors);
+	CHECK_EQUAL(0, loc_report._u32_nbErrors);
+	CHECK_EQUAL(2500, loc_teleinfo.getFrame()._u32_appPower);
+	hostClockRelease();
+}
+
+static void testCaptureFull(void)
+{
+	std::vector<uint8_t> loc_capture;
+
+	hostClockSet(0);
+	loc_capture = record(historicFrame(), HISTORIC_BYTE_US, TeleinfoCapture::HEADER_LENGTH + 10 * TeleinfoCapture::RECORD_LENGTH + 2);
+	CHECK_EQUAL(TeleinfoCapture::HEADER_LENGTH + 10 * TeleinfoCapture::RECORD_LENGTH, loc_capture.size());
+	CHECK(captureBytes(loc_capture) == historicFrame().substr(0, 10));
+	hostClockRelease();
+}
+
+static void testRealtimeReplay(void)
+{
+	std::vector<uint8_t> loc_capture;
+
+	/** second byte after more than 2^32 us : delay saturated */
+	hostClockSet(0);
+	{
+		std::vector<uint8_t> loc_buffer(TeleinfoCapture::HEADER_LENGTH + 3 * TeleinfoCapture::RECORD_LENGTH);
+		StringStream loc_stream("\x02\n\x03");
+		TeleinfoCaptureRecorder loc_recorder(loc_stream, loc_buffer.data(), loc_buffer.size(), Teleinfo::HISTORIC_BAUDRATE);
+		hostClockAdvance(100);
+		loc_recorder.read();
+		hostClockAdvance(MICROS_WRAP_US + 5);
+		loc_recorder.read();
+		hostClockAdvance(0xF0000000);
+		loc_recorder.read();
+		loc_capture = loc_buffer;
+	}
+	CHECK_EQUAL(100, recordDelay(loc_capture, 0));
+	CHECK_EQUAL(0xFFFFFFFF, recordDelay(loc_capture, 1));
+	CHECK_EQUAL(0xF0000000, recordDelay(loc_capture, 2));
+
+	/** replay started close to micros() wrap, last byte more than 2^32 us after start */
+	TeleinfoCaptureStream loc_stream(loc_capture.data(), loc_capture.size());
+	hostClockSet(MICROS_WRAP_US - 50);
+	loc_stream.start(TeleinfoCaptureStream::REPLAY_REALTIME);
+	hostClockAdvance(99);
+	CHECK_EQUAL(0, loc_stream.available());
+	hostClockAdvance(1);
+	CHECK_EQUAL(0x02, loc_stream.read());
+	hostClockAdvance(0xFFFFFFFE);
+	CHECK_EQUAL(0, loc_stream.available());
+	hostClockAdvance(1);
+	CHECK_EQUAL('\n', loc_stream.read());
+	hostClockAdvance(0xEFFFFFFF);
+	CHECK_EQUAL(0, loc_stream.available());
+	hostClockAdvance(1);
+	CHECK_EQUAL(0x03, loc_stream.read());
+	CHECK(loc_stream.isFinished());
+
+	/** accelerated : recorded delays divided by factor */
+	loc_stream.start(TeleinfoCaptureStream::REPLAY_ACCELERATED, 4);
+	hostClockAdvance(24);
+	CHECK_EQUAL(0, loc_stream.available());
+	hostClockAdvance(1);
+	CHECK_EQUAL(0x02, loc_stream.read());
+	hostClockRelease();
+}
+
+TELEINFO_TEST_MAIN(testRecordReplay, testCaptureFull, testRealtimeReplay)
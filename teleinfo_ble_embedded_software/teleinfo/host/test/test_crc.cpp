@@ -0,0 +1,127 @@
+/******************************************************************************
+ * @file    test_crc.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Group CRC host tests - historic CRC excludes separator before CRC,
+ * standard CRC includes it
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_test.h"
+#include "teleinfo.h"
+#include "teleinfo_host_frames.h"
+
+using namespace TeleinfoHostFrames;
+
+/*************************************
+ * Private definitions
+ *************************************/
+/**
+ * Groups with CRC computed by hand, not with TeleinfoHostFrames::checksum(),
+ * so that a CRC rule error shared by parser and test helpers is caught
+ */
+/** CRC of "HCHC 001234567" */
+static const char HISTORIC_GROUP[] = "\nHCHC 001234567 \"\r";
+/** CRC of "HCHC 001234567 " : standard rule applied to an historic group */
+static const char HISTORIC_GROUP_SEPARATOR_CRC[] = "\nHCHC 001234567 B\r";
+/** CRC is a space : CRC equal to separator */
+static const char HISTORIC_GROUP_SPACE_CRC[] = "\nHCHC 001234529  \r";
+/** CRC of "EAST\t001234567\t" */
+static const char STANDARD_GROUP[] = "\nEAST\t001234567\t+\r";
+/** CRC of "EAST\t001234567" : historic rule applied to a standard group */
+static const char STANDARD_GROUP_NO_SEPARATOR_CRC[] = "\nEAST\t001234567\t\"\r";
+/** CRC of "SINSTS\tE250101120000\t02500\t" - timestamp part of CRC */
+static const char TIMESTAMPED_GROUP[] = "\nSINSTS\tE250101120000\t02500\t'\r";
+/** CRC of "SINSTS\t02500\t" : timestamp left out of CRC */
+static const char TIMESTAMPED_GROUP_NO_TIMESTAMP_CRC[] = "\nSINSTS\tE250101120000\t02500\tM\r";
+
+/** feed a frame made of given group */
+static Teleinfo::EError feedFrame(Teleinfo& arg_teleinfo, const std::string& arg_group)
+{
+	std::string loc_frame = frame(arg_group);
+	return arg_teleinfo.feed((const uint8_t*) loc_frame.data(), loc_frame.size());
+}
+
+/*************************************
+ * Tests
+ *************************************/
+static void testHelperChecksum(void)
+{
+	CHECK_EQUAL('"', checksum("HCHC 001234567"));
+	CHECK_EQUAL('+', checksum("EAST\t001234567\t"));
+	CHECK(historicGroup("HCHC", "001234567") == HISTORIC_GROUP);
+	CHECK(standardGroup("EAST", "001234567") == STANDARD_GROUP);
+	CHECK(standardGroup("SINSTS", "02500", "E250101120000") == TIMESTAMPED_GROUP);
+}
+
+static void testHistoricCRC(void)
+{
+	Teleinfo loc_teleinfo(NULL);
+
+	feedFrame(loc_teleinfo, HISTORIC_GROUP);
+	CHECK_EQUAL(0, loc_teleinfo.getStats()._u32_nbCRCErrors);
+	CHECK_EQUAL(1234567, loc_teleinfo.getFrame()._u32_hcIndex);
+	CHECK_EQUAL(Teleinfo::TIC_MODE_HISTORIC, loc_teleinfo.getMode());
+
+	feedFrame(loc_teleinfo, HISTORIC_GROUP_SEPARATOR_CRC);
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbCRCErrors);
+	CHECK(loc_teleinfo.getFrame()._b_partialFrame);
+
+	feedFrame(loc_teleinfo, HISTORIC_GROUP_SPACE_CRC);
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbCRCErrors);
+	CHECK_EQUAL(1234529, loc_teleinfo.getFrame()._u32_hcIndex);
+}
+
+static void testStandardCRC(void)
+{
+	Teleinfo loc_teleinfo(NULL);
+
+	feedFrame(loc_teleinfo, STANDARD_GROUP);
+	CHECK_EQUAL(0, loc_teleinfo.getStats()._u32_nbCRCErrors);
+	CHECK_EQUAL(1234567, loc_teleinfo.getFrame()._u32_baseIndex);
+	CHECK_EQUAL(Teleinfo::TIC_MODE_STANDARD, loc_teleinfo.getMode());
+
+	feedFrame(loc_teleinfo, STANDARD_GROUP_NO_SEPARATOR_CRC);
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbCRCErrors);
+	CHECK(loc_teleinfo.getFrame()._b_partialFrame);
+}
+
+static void testTimestampedCRC(void)
+{
+	Teleinfo loc_teleinfo(NULL);
+
+	feedFrame(loc_teleinfo, TIMESTAMPED_GROUP);
+	CHECK_EQUAL(0, loc_teleinfo.getStats()._u32_nbCRCErrors);
+	CHECK_EQUAL(2500, loc_teleinfo.getFrame()._u32_appPower);
+
+	feedFrame(loc_teleinfo, TIMESTAMPED_GROUP_NO_TIMESTAMP_CRC);
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbCRCErrors);
+}
+
+static void testCorruptedByte(void)
+{
+	Teleinfo loc_teleinfo(NULL);
+	std::string loc_group = STANDARD_GROUP;
+
+	/** single bit error in value : same length, CRC no more matching */
+	loc_group[8] ^= 0x01;
+	feedFrame(loc_teleinfo, loc_group);
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbCRCErrors);
+	CHECK_EQUAL(0, loc_teleinfo.getFrame()._u32_baseIndex);
+	CHECK_EQUAL(0, loc_teleinfo.getNbValidGroups());
+}
+
+TELEINFO_TEST_MAIN(testHelperChecksum, testHistoricCRC, testStandardCRC, testTimestampedCRC, testCorruptedByte)
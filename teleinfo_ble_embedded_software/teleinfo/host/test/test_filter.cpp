@@ -0,0 +1,194 @@
+/******************************************************************************
+ * @file    test_filter.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Field filter host tests
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_test.h"
+#include "teleinfo_filter.h"
+#include "host_clock.h"
+#include <string.h>
+
+/*************************************
+ * Private definitions
+ *************************************/
+/** records forwarded notifications */
+class FrameListener : public ITeleinfoListener {
+public:
+	uint32_t _u32_nbFrames;
+	TeleinfoFieldMask _lastMask;
+	FrameListener(void) : _u32_nbFrames(0), _lastMask(0){};
+	void onFrame(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask)
+	{
+		_u32_nbFrames++;
+		_lastMask = arg_changedMask;
+	};
+};
+
+static const TeleinfoFieldMask PAPP_MASK = teleinfoFieldMask(PAPP_FIELD);
+
+static void advanceMs(uint32_t arg_u32_ms)
+{
+	hostClockAdvance((uint64_t) arg_u32_ms * 1000);
+}
+
+/** notify filter with a frame changing PAPP to given value */
+static void changePower(TeleinfoFilter& arg_filter, TeleinfoFrame& arg_frame, uint32_t arg_u32_appPower)
+{
+	arg_frame._u32_appPower = arg_u32_appPower;
+	arg_filter.onFrame(arg_frame, PAPP_MASK);
+}
+
+/*************************************
+ * Tests
+ *************************************/
+static void testDeadband(void)
+{
+	FrameListener loc_listener;
+	TeleinfoFilter loc_filter(loc_listener);
+	TeleinfoFrame loc_frame;
+
+	memset(&loc_frame, 0, sizeof(loc_frame));
+	hostClockSet(0);
+	/** 20 VA or 2% - no min interval */
+	CHECK(loc_filter.setFieldFilter(PAPP_FIELD, 20, 20, 0, 60000));
+
+	changePower(loc_filter, loc_frame, 2500);
+	CHECK_EQUAL(1, loc_listener._u32_nbFrames);
+	CHECK_EQUAL(PAPP_MASK, loc_listener._lastMask);
+
+	/** within 2% of 2500 */
+	changePower(loc_filter, loc_frame, 2540);
+	changePower(loc_filter, loc_frame, 2460);
+	CHECK_EQUAL(1, loc_listener._u32_nbFrames);
+
+	changePower(loc_filter, loc_frame, 2560);
+	CHECK_EQUAL(2, loc_listener._u32_nbFrames);
+	hostClockRelease();
+}
+
+static void testHysteresis(void)
+{
+	FrameListener loc_listener;
+	TeleinfoFilter loc_filter(loc_listener);
+	TeleinfoFrame loc_frame;
+
+	memset(&loc_frame, 0, sizeof(loc_frame));
+	hostClockSet(0);
+	CHECK(loc_filter.setFieldFilter(PAPP_FIELD, 100, 0, 5000, 0));
+	changePower(loc_filter, loc_frame, 1000);
+	CHECK_EQUAL(1, loc_listener._u32_nbFrames);
+
+	/** change delayed by min interval, kept while value jitters around deadband edge */
+	advanceMs(1000);
+	changePower(loc_filter, loc_frame, 1110);
+	changePower(loc_filter, loc_frame, 1090);
+	changePower(loc_filter, loc_frame, 1060);
+	CHECK_EQUAL(1, loc_listener._u32_nbFrames);
+	advanceMs(4000);
+	loc_filter.refresh();
+	CHECK_EQUAL(2, loc_listener._u32_nbFrames);
+	CHECK_EQUAL(1060, loc_frame._u32_appPower);
+
+	/** value back within half deadband : delayed change cancelled */
+	advanceMs(1000);
+	changePower(loc_filter, loc_frame, 1200);
+	changePower(loc_filter, loc_frame, 1100);
+	advanceMs(4000);
+	loc_filter.refresh();
+	CHECK_EQUAL(2, loc_listener._u32_nbFrames);
+	hostClockRelease();
+}
+
+static void testReconfigure(void)
+{
+	FrameListener loc_listener;
+	TeleinfoFilter loc_filter(loc_listener);
+	TeleinfoFrame loc_frame;
+
+	memset(&loc_frame, 0, sizeof(loc_frame));
+	hostClockSet(0);
+	CHECK(loc_filter.setFieldFilter(PAPP_FIELD, 20, 0, 0, 10000));
+	changePower(loc_filter, loc_frame, 2500);
+	CHECK_EQUAL(1, loc_listener._u32_nbFrames);
+
+	/** steady value : refreshed after reconfiguration too */
+	advanceMs(5000);
+	CHECK(loc_filter.setFieldFilter(PAPP_FIELD, 50, 0, 0, 20000));
+	advanceMs(19999);
+	loc_filter.refresh();
+	CHECK_EQUAL(1, loc_listener._u32_nbFrames);
+	advanceMs(1);
+	loc_filter.refresh();
+	CHECK_EQUAL(2, loc_listener._u32_nbFrames);
+	CHECK_EQUAL(PAPP_MASK, loc_listener._lastMask);
+
+	/** deadband measured from seeded value */
+	CHECK(loc_filter.setFieldFilter(PAPP_FIELD, 50, 0, 0, 20000));
+	changePower(loc_filter, loc_frame, 2540);
+	CHECK_EQUAL(2, loc_listener._u32_nbFrames);
+	changePower(loc_filter, loc_frame, 2560);
+	CHECK_EQUAL(3, loc_listener._u32_nbFrames);
+	hostClockRelease();
+}
+
+static void testNonNumericField(void)
+{
+	FrameListener loc_listener;
+	TeleinfoFilter loc_filter(loc_listener);
+
+	/** no value to measure changes on : would suppress every change */
+	CHECK(!loc_filter.setFieldFilter(PTEC_FIELD, 1, 0, 0, 60000));
+	CHECK(!loc_filter.setFieldFilter(DEMAIN_FIELD, 1, 0, 0, 60000));
+	CHECK(!loc_filter.setFieldFilter(ADCO_FIELD, 1, 0, 0, 60000));
+	CHECK(loc_filter.setFieldFilter(PHASE_IINST_FIELD, 1, 0, 0, 60000));
+}
+
+static void testRemoveFilter(void)
+{
+	static const ETeleinfoField FILTERED_FIELDS[TeleinfoFilter::MAX_FILTERED_FIELDS] = {PAPP_FIELD, IINST_FIELD,
+			IMAX_FIELD, ISOUSC_FIELD, BASE_FIELD, HCHC_FIELD, HCHP_FIELD, PMAX_FIELD};
+	FrameListener loc_listener;
+	TeleinfoFilter loc_filter(loc_listener);
+	TeleinfoFrame loc_frame;
+
+	memset(&loc_frame, 0, sizeof(loc_frame));
+	hostClockSet(0);
+	for(uint8_t loc_u8_index = 0; loc_u8_index < TeleinfoFilter::MAX_FILTERED_FIELDS; loc_u8_index++)
+	{
+		CHECK(loc_filter.setFieldFilter(FILTERED_FIELDS[loc_u8_index], 100, 0, 0, 60000));
+	}
+	CHECK(!loc_filter.setFieldFilter(URMS1_FIELD, 10, 0, 0, 60000));
+
+	changePower(loc_filter, loc_frame, 1000);
+	changePower(loc_filter, loc_frame, 1050);
+	CHECK_EQUAL(1, loc_listener._u32_nbFrames);
+
+	/** all settings 0 : slot freed, PAPP forwarded on each change */
+	CHECK(loc_filter.setFieldFilter(PAPP_FIELD, 0, 0, 0, 0));
+	CHECK(loc_filter.setFieldFilter(URMS1_FIELD, 10, 0, 0, 60000));
+	changePower(loc_filter, loc_frame, 1060);
+	CHECK_EQUAL(2, loc_listener._u32_nbFrames);
+	CHECK_EQUAL(PAPP_MASK, loc_listener._lastMask);
+
+	/** removing an unfiltered field is harmless */
+	CHECK(loc_filter.setFieldFilter(PAPP_FIELD, 0, 0, 0, 0));
+	hostClockRelease();
+}
+
+TELEINFO_TEST_MAIN(testDeadband, testHysteresis, testReconfigure, testNonNumericField, testRemoveFilter)
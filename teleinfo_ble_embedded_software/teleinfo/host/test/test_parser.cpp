@@ -0,0 +1,234 @@
+/******************************************************************************
+ * @file    test_parser.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Byte-fed teleinfo parser host tests
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_test.h"
+#include "teleinfo.h"
+#include "teleinfo_host_frames.h"
+#include "host_clock.h"
+#include <string.h>
+
+using namespace TeleinfoHostFrames;
+
+/*************************************
+ * Private definitions
+ *************************************/
+/** records last notification */
+class FrameListener : public ITeleinfoListener {
+public:
+	uint32_t _u32_nbFrames;
+	TeleinfoFieldMask _lastMask;
+	FrameListener(void) : _u32_nbFrames(0), _lastMask(0){};
+	void onFrame(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask)
+	{
+		_u32_nbFrames++;
+		_lastMask = arg_changedMask;
+	};
+};
+
+static Teleinfo::EError feed(Teleinfo& arg_teleinfo, const std::string& arg_bytes)
+{
+	return arg_teleinfo.feed((const uint8_t*) arg_bytes.data(), arg_bytes.size());
+}
+
+static void checkHistoricValues(const TeleinfoFrame& arg_frame)
+{
+	CHECK(strcmp(arg_frame._as8_hubAddr, "012345678901") == 0);
+	CHECK_EQUAL(HC_TAR, arg_frame._u8_optTar);
+	CHECK_EQUAL(45, arg_frame._u16_souscInt);
+	CHECK_EQUAL(1234567, arg_frame._u32_hcIndex);
+	CHECK_EQUAL(7654321, arg_frame._u32_hpIndex);
+	CHECK_EQUAL(HP, arg_frame._u8_currTar);
+	CHECK_EQUAL(10, arg_frame._u16_instInt);
+	CHECK_EQUAL(2500, arg_frame._u32_appPower);
+	CHECK_EQUAL('A', arg_frame._s8_hhphc);
+	CHECK(strcmp(arg_frame._as8_modEtat, "000000") == 0);
+}
+
+/*************************************
+ * Tests
+ *************************************/
+static void testHistoricFrame(void)
+{
+	Teleinfo loc_teleinfo(NULL);
+	FrameListener loc_listener;
+
+	loc_teleinfo.registerListener(loc_listener);
+	CHECK_EQUAL(Teleinfo::FRAME_AVAILABLE, feed(loc_teleinfo, historicFrame()));
+	CHECK_EQUAL(Teleinfo::TIC_MODE_HISTORIC, loc_teleinfo.getMode());
+	CHECK_EQUAL(1, loc_listener._u32_nbFrames);
+	CHECK(loc_listener._lastMask & teleinfoFieldMask(PAPP_FIELD));
+	CHECK(!loc_teleinfo.getFrame()._b_partialFrame);
+	CHECK_EQUAL(11, loc_teleinfo.getStats()._u32_nbGroups);
+	checkHistoricValues(loc_teleinfo.getFrame());
+
+	/** same frame : nothing changed, nothing notified */
+	feed(loc_teleinfo, historicFrame());
+	CHECK_EQUAL(1, loc_listener._u32_nbFrames);
+
+	feed(loc_teleinfo, historicFrame(2520));
+	CHECK_EQUAL(2, loc_listener._u32_nbFrames);
+	CHECK_EQUAL(teleinfoFieldMask(PAPP_FIELD), loc_listener._lastMask);
+}
+
+static void testByteByByte(void)
+{
+	Teleinfo loc_teleinfo(NULL);
+	std::string loc_frame = historicFrame();
+	uint32_t loc_u32_nbFrameAvailable = 0;
+
+	/** state kept between calls whatever the split */
+	for(size_t loc_u32_index = 0; loc_u32_index < loc_frame.size(); loc_u32_index++)
+	{
+		if(loc_teleinfo.feed((uint8_t) loc_frame[loc_u32_index]) == Teleinfo::FRAME_AVAILABLE)
+		{
+			loc_u32_nbFrameAvailable++;
+			CHECK_EQUAL(loc_frame.size() - 1, loc_u32_index);
+		}
+	}
+	CHECK_EQUAL(1, loc_u32_nbFrameAvailable);
+	checkHistoricValues(loc_teleinfo.getFrame());
+
+	for(size_t loc_u32_chunk = 2; loc_u32_chunk < 40; loc_u32_chunk += 7)
+	{
+		Teleinfo loc_chunked(NULL);
+		for(size_t loc_u32_index = 0; loc_u32_index < loc_frame.size(); loc_u32_index += loc_u32_chunk)
+		{
+			feed(loc_chunked, loc_frame.substr(loc_u32_index, loc_u32_chunk));
+		}
+		CHECK_EQUAL(1, loc_chunked.getStats()._u32_nbFrames);
+		checkHistoricValues(loc_chunked.getFrame());
+	}
+}
+
+static void testParityBit(void)
+{
+	Teleinfo loc_teleinfo(NULL);
+
+	/** 7E1 line read as 8N1 */
+	CHECK_EQUAL(Teleinfo::FRAME_AVAILABLE, feed(loc_teleinfo, withParity(historicFrame())));
+	checkHistoricValues(loc_teleinfo.getFrame());
+}
+
+static void testStandardFrame(void)
+{
+	Teleinfo loc_teleinfo(NULL);
+	const TeleinfoFrame& loc_frame = loc_teleinfo.getFrame();
+
+	CHECK_EQUAL(Teleinfo::FRAME_AVAILABLE, feed(loc_teleinfo, standardFrame(3000, 1234567)));
+	CHECK_EQUAL(Teleinfo::TIC_MODE_STANDARD, loc_teleinfo.getMode());
+	CHECK(strcmp(loc_frame._as8_hubAddr, "041876097815") == 0);
+	CHECK(strcmp(loc_frame._as8_tariffName, "      TEMPO     ") == 0);
+	CHECK_EQUAL(1234567, loc_frame._u32_baseIndex);
+	CHECK_EQUAL(1234567 / 3, loc_frame._u32_hcIndex);
+	CHECK_EQUAL(3000, loc_frame._u32_appPower);
+	CHECK_EQUAL(231, loc_frame._u16_rmsVoltage);
+	CHECK_EQUAL(0x003A0001, loc_frame._u32_status);
+	CHECK_EQUAL(2, loc_frame._u8_tariffIndex);
+	CHECK(!loc_frame._b_partialFrame);
+	CHECK_EQUAL(0, loc_teleinfo.getStats()._u32_nbCRCErrors);
+	CHECK(loc_teleinfo.getStats()._u32_nbUnhandledGroups > 0);
+}
+
+static void testInvalidGroup(void)
+{
+	Teleinfo loc_teleinfo(NULL);
+	std::string loc_papp = historicGroup("PAPP", "02500");
+
+	/** wrong checksum : group dropped, frame partial, other groups kept */
+	loc_papp[loc_papp.size() - 2]++;
+	CHECK_EQUAL(Teleinfo::FRAME_AVAILABLE, feed(loc_teleinfo, frame(historicGroup("IINST", "012") + loc_papp + historicGroup("ISOUSC", "45"))));
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbCRCErrors);
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbPartialFrames);
+	CHECK(loc_teleinfo.getFrame()._b_partialFrame);
+	CHECK_EQUAL(0, loc_teleinfo.getFrame()._u32_appPower);
+	CHECK_EQUAL(12, loc_teleinfo.getFrame()._u16_instInt);
+	CHECK_EQUAL(45, loc_teleinfo.getFrame()._u16_souscInt);
+
+	/** non digit value */
+	feed(loc_teleinfo, frame(historicGroup("PAPP", "02A00")));
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbValueErrors);
+	CHECK_EQUAL(0, loc_teleinfo.getFrame()._u32_appPower);
+}
+
+static void testResync(void)
+{
+	Teleinfo loc_teleinfo(NULL);
+	std::string loc_frame = historicFrame();
+
+	/** started in the middle of a frame : waits for STX */
+	CHECK_EQUAL(Teleinfo::FRAME_AVAILABLE, feed(loc_teleinfo, loc_frame.substr(loc_frame.size() / 2) + loc_frame));
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbFrames);
+	checkHistoricValues(loc_teleinfo.getFrame());
+
+	/** EOT interrupts transmission, frame dropped */
+	feed(loc_teleinfo, loc_frame.substr(0, loc_frame.size() / 2) + "\x04");
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbFrames);
+	feed(loc_teleinfo, loc_frame);
+	CHECK_EQUAL(2, loc_teleinfo.getStats()._u32_nbFrames);
+}
+
+static void testInterruptedGroup(void)
+{
+	Teleinfo loc_teleinfo(NULL);
+	FrameListener loc_listener;
+
+	hostClockSet(1000000);
+	loc_teleinfo.registerListener(loc_listener);
+	feed(loc_teleinfo, historicFrame());
+	CHECK_EQUAL(0, loc_teleinfo.getFieldAge(PAPP_FIELD));
+
+	/** new frame starts in the middle of HCHC group : group error, PAPP change kept */
+	hostClockAdvance(2000000);
+	feed(loc_teleinfo, "\x02" + historicGroup("PAPP", "02520") + "\nHCHC 0012");
+	CHECK_EQUAL(Teleinfo::INVALID_READ, loc_teleinfo.feed((uint8_t) 0x02));
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbReadErrors);
+	CHECK_EQUAL(Teleinfo::FRAME_AVAILABLE, feed(loc_teleinfo, historicGroup("ADCO", "012345678901") + "\x03"));
+	CHECK_EQUAL(2, loc_listener._u32_nbFrames);
+	CHECK(loc_listener._lastMask & teleinfoFieldMask(PAPP_FIELD));
+	CHECK(loc_teleinfo.getFrame()._b_partialFrame);
+	CHECK_EQUAL(2520, loc_teleinfo.getFrame()._u32_appPower);
+	CHECK_EQUAL(1234567, loc_teleinfo.getFrame()._u32_hcIndex);
+	/** PAPP not received in notified frame */
+	CHECK_EQUAL(2000, loc_teleinfo.getFieldAge(PAPP_FIELD));
+	CHECK_EQUAL(0, loc_teleinfo.getFieldAge(ADCO_FIELD));
+
+	/** STX between two groups : ETX lost, frame partial, no group error */
+	feed(loc_teleinfo, "\x02" + historicGroup("PAPP", "02530"));
+	CHECK_EQUAL(Teleinfo::NO_ERROR, loc_teleinfo.feed((uint8_t) 0x02));
+	CHECK_EQUAL(1, loc_teleinfo.getStats()._u32_nbReadErrors);
+	CHECK_EQUAL(Teleinfo::FRAME_AVAILABLE, feed(loc_teleinfo, historicGroup("ADCO", "012345678901") + "\x03"));
+	CHECK_EQUAL(3, loc_listener._u32_nbFrames);
+	CHECK(loc_teleinfo.getFrame()._b_partialFrame);
+	CHECK_EQUAL(2530, loc_teleinfo.getFrame()._u32_appPower);
+
+	/** group skipped then STX between groups : frame still partial */
+	feed(loc_teleinfo, "\x02" + historicGroup("PAPP", "0254x") + historicGroup("PAPP", "02550"));
+	CHECK_EQUAL(Teleinfo::NO_ERROR, loc_teleinfo.feed((uint8_t) 0x02));
+	CHECK_EQUAL(Teleinfo::FRAME_AVAILABLE, feed(loc_teleinfo, historicGroup("ADCO", "012345678901") + "\x03"));
+	CHECK(loc_teleinfo.getFrame()._b_partialFrame);
+
+	/** complete frame */
+	CHECK_EQUAL(Teleinfo::FRAME_AVAILABLE, feed(loc_teleinfo, historicFrame()));
+	CHECK(!loc_teleinfo.getFrame()._b_partialFrame);
+	hostClockRelease();
+}
+
+TELEINFO_TEST_MAIN(testHistoricFrame, testByteByByte, testParityBit, testStandardFrame, testInvalidGroup, testResync, testInterruptedGroup)
@@ -0,0 +1,100 @@
+/******************************************************************************
+ * @file    test_power.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Real power estimator host tests
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_test.h"
+#include "teleinfo_power.h"
+#include "host_clock.h"
+#include <string.h>
+
+/*************************************
+ * Private definitions
+ *************************************/
+/** 10Wh every 36s : 1000W */
+static const uint32_t STEP_WH = 10;
+static const uint32_t STEP_MS = 36000;
+
+static void advanceMs(uint32_t arg_u32_ms)
+{
+	hostClockAdvance((uint64_t) arg_u32_ms * 1000);
+}
+
+/*************************************
+ * Tests
+ *************************************/
+static void testStandardIndexes(void)
+{
+	TeleinfoPowerEstimator loc_estimator;
+	TeleinfoFrame loc_frame;
+
+	/** EAST stored in BASE, EASF01/02 in HCHC/HCHP : same energy counted by both */
+	memset(&loc_frame, 0, sizeof(loc_frame));
+	loc_frame._u32_baseIndex = 1000000;
+	loc_frame._u32_hcIndex = 400000;
+	loc_frame._u32_hpIndex = 600000;
+	hostClockSet(0);
+
+	/** first frame, then first increment as measure origin */
+	for(uint8_t loc_u8_step = 0; loc_u8_step < 2; loc_u8_step++)
+	{
+		loc_estimator.onFrame(loc_frame, ALL_TELEINFO_FIELDS);
+		CHECK_EQUAL(TeleinfoPowerEstimator::INVALID_POWER, loc_estimator.getRealPower());
+		advanceMs(STEP_MS);
+		loc_frame._u32_baseIndex += STEP_WH;
+		loc_frame._u32_hpIndex += STEP_WH;
+	}
+	loc_estimator.onFrame(loc_frame, ALL_TELEINFO_FIELDS);
+	CHECK_EQUAL(1000, loc_estimator.getRealPower());
+	hostClockRelease();
+}
+
+static void testIndexesSumOverflow(void)
+{
+	TeleinfoPowerEstimator loc_estimator;
+	TeleinfoFrame loc_frame;
+
+	/** Tempo indexes sum 15Wh below 2^32 : sum wraps on second step */
+	memset(&loc_frame, 0, sizeof(loc_frame));
+	loc_frame._u8_currTar = HPJR;
+	loc_frame._u32_bbrHCJBIndex = 999999999;
+	loc_frame._u32_bbrHPJBIndex = 999999999;
+	loc_frame._u32_bbrHCJWIndex = 999999999;
+	loc_frame._u32_bbrHPJWIndex = 999999999;
+	loc_frame._u32_bbrHCJRIndex = 294967281;
+	loc_frame._u32_bbrHPJRIndex = 4;
+	hostClockSet(0);
+
+	for(uint8_t loc_u8_step = 0; loc_u8_step < 2; loc_u8_step++)
+	{
+		loc_estimator.onFrame(loc_frame, ALL_TELEINFO_FIELDS);
+		advanceMs(STEP_MS);
+		loc_frame._u32_bbrHPJRIndex += STEP_WH;
+	}
+	loc_estimator.onFrame(loc_frame, ALL_TELEINFO_FIELDS);
+	CHECK_EQUAL(1000, loc_estimator.getRealPower());
+
+	/** index going backwards : measure restarted, estimate kept */
+	loc_frame._u32_bbrHPJRIndex -= 1;
+	loc_estimator.onFrame(loc_frame, ALL_TELEINFO_FIELDS);
+	CHECK_EQUAL(1000, loc_estimator.getRealPower());
+	hostClockRelease();
+}
+
+TELEINFO_TEST_MAIN(testStandardIndexes, testIndexesSumOverflow)
@@ -0,0 +1,82 @@
+/******************************************************************************
+ * @file    test_raw.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Raw frame capture host tests
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_test.h"
+#include "teleinfo_raw.h"
+#include "teleinfo_host_frames.h"
+
+using namespace TeleinfoHostFrames;
+
+/*************************************
+ * Private definitions
+ *************************************/
+/** BLE notification length minus notification type */
+static const uint8_t CHUNK_LENGTH = 19;
+
+/** read out ready frame */
+static std::string readFrame(TeleinfoRawCapture& arg_capture, uint8_t& arg_u8_lastChunkIndex)
+{
+	uint8_t loc_au8_chunk[CHUNK_LENGTH];
+	uint8_t loc_u8_length;
+	std::string loc_frame;
+
+	arg_u8_lastChunkIndex = 0;
+	while((loc_u8_length = arg_capture.peekChunk(loc_au8_chunk)) > 0)
+	{
+		loc_frame.append((const char*) &loc_au8_chunk[TeleinfoRawCapture::CHUNK_HEADER_LENGTH],
+				loc_u8_length - TeleinfoRawCapture::CHUNK_HEADER_LENGTH);
+		arg_u8_lastChunkIndex = loc_au8_chunk[1];
+		arg_capture.releaseChunk();
+	}
+	return loc_frame;
+}
+
+/*************************************
+ * Tests
+ *************************************/
+static void testCapture(void)
+{
+	TeleinfoRawCapture loc_capture(CHUNK_LENGTH);
+	std::string loc_frame = historicFrame();
+	uint8_t loc_u8_lastChunkIndex;
+
+	/** bytes before first STX ignored */
+	loc_capture.feed((const uint8_t*) "\r\n", 2);
+	loc_capture.feed((const uint8_t*) loc_frame.data(), loc_frame.size());
+	CHECK(readFrame(loc_capture, loc_u8_lastChunkIndex) == loc_frame);
+	CHECK(loc_u8_lastChunkIndex & TeleinfoRawCapture::LAST_CHUNK_FLAG);
+	CHECK(!(loc_u8_lastChunkIndex & TeleinfoRawCapture::TRUNCATED_FLAG));
+}
+
+static void testParityBit(void)
+{
+	TeleinfoRawCapture loc_capture(CHUNK_LENGTH);
+	std::string loc_frame = historicFrame();
+	std::string loc_received = withParity(loc_frame);
+	uint8_t loc_u8_lastChunkIndex;
+
+	/** 7E1 line read as 8N1 : STX and ETX only found once parity bit cleared, forwarded without it */
+	loc_capture.feed((const uint8_t*) loc_received.data(), loc_received.size());
+	CHECK(readFrame(loc_capture, loc_u8_lastChunkIndex) == loc_frame);
+	CHECK_EQUAL(0, loc_capture.getNbDroppedFrames());
+}
+
+TELEINFO_TEST_MAIN(testCapture, testParityBit)
@@ -0,0 +1,95 @@
+/******************************************************************************
+ * @file    teleinfo_replay.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Replay a TeleinfoCapture file recorded on device through the parser
+ * and print replay report.
+ * Usage : teleinfo_replay capture_file [realtime | accelerated factor | unthrottled]
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo.h"
+#include "teleinfo_capture.h"
+#include "teleinfo_host_frames.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*************************************
+ * Private functions
+ *************************************/
+static int usage(const char* arg_s8_name)
+{
+	fprintf(stderr, "usage : %s capture_file [realtime | accelerated factor | unthrottled]\n", arg_s8_name);
+	return 2;
+}
+
+/*************************************
+ * Entry point
+ *************************************/
+int main(int argc, char** argv)
+{
+	std::vector<uint8_t> loc_capture;
+	TeleinfoCaptureStream::EReplaySpeed loc_e_speed = TeleinfoCaptureStream::REPLAY_UNTHROTTLED;
+	uint16_t loc_u16_speedFactor = 1;
+	TeleinfoReplayReport loc_report;
+	Teleinfo loc_teleinfo(NULL);
+
+	if(argc < 2)
+	{
+		return usage(argv[0]);
+	}
+	if(argc >= 3 && strcmp(argv[2], "realtime") == 0)
+	{
+		loc_e_speed = TeleinfoCaptureStream::REPLAY_REALTIME;
+	}
+	else if(argc >= 4 && strcmp(argv[2], "accelerated") == 0)
+	{
+		loc_e_speed = TeleinfoCaptureStream::REPLAY_ACCELERATED;
+		loc_u16_speedFactor = (uint16_t) atoi(argv[3]);
+	}
+	else if(argc >= 3 && strcmp(argv[2], "unthrottled") != 0)
+	{
+		return usage(argv[0]);
+	}
+
+	if(!TeleinfoHostFrames::loadCapture(argv[1], loc_capture))
+	{
+		fprintf(stderr, "cannot read %s\n", argv[1]);
+		return 1;
+	}
+	TeleinfoCaptureStream loc_stream(loc_capture.data(), loc_capture.size());
+	if(!loc_stream.isValid())
+	{
+		fprintf(stderr, "%s is not a teleinfo capture\n", argv[1]);
+		return 1;
+	}
+
+	loc_stream.start(loc_e_speed, loc_u16_speedFactor);
+	replayTeleinfoCapture(loc_teleinfo, loc_stream, loc_report);
+
+	printf("capture          : %s - %u bauds\n", argv[1], loc_stream.getBaudrate());
+	printf("bytes            : %u\n", loc_report._u32_nbBytes);
+	printf("frames           : %u - %u/s\n", loc_report._u32_nbFrames, loc_report.framesPerSecond());
+	printf("groups           : %u - %u/s\n", loc_report._u32_nbGroups, loc_report.groupsPerSecond());
+	printf("ignored groups   : %u\n", loc_report._u32_nbIgnoredGroups);
+	printf("CRC errors       : %u\n", loc_report._u32_nbCRCErrors);
+	printf("other errors     : %u\n", loc_report._u32_nbErrors);
+	printf("elapsed          : %u us\n", loc_report._u32_elapsedUs);
+	printf("frame parse time : min %u us - avg %u us - max %u us\n", loc_report._u32_minFrameParseUs,
+			loc_report.avgFrameParseUs(), loc_report._u32_maxFrameParseUs);
+	return 0;
+}
@@ -21,7 +21,10 @@
  *****************************************************************************/
 #include "teleinfo.h"
 #include "teleinfo_fields.h"
+#include "teleinfo_labels.h"
 #include <delay.h>
+#include <stddef.h>
+#include <string.h>
 #include <logger.h>
 
 
@@ -29,36 +32,170 @@
  * TYPES only used in this source file
  *************************************/
 
-struct PTECMapping{
-	const char* _teleinfoField;
-	EPTEC _e_Val;
+/** 4 chars value to enum mapping - value packed in an integer, first char in LSB */
+struct ValueMapping{
+	uint32_t _u32_value;
+	uint8_t _u8_enum;
 };
 
-struct OPTarMapping{
-	const char* _teleinfoField;
-	EOptTar _e_Val;
+/** Field storage type in TeleinfoFrame */
+typedef enum{
+	VALUE_U8,
+	VALUE_U16,
+	VALUE_U32,
+	VALUE_CHAR,
+	/** null terminated string copied as received */
+	VALUE_STRING,
+}EValueType;
+
+/**
+ * Convert a raw received value
+ * @param arg_au8_value null terminated value
+ * @param arg_u8_valueLen
+ * @param arg_p_u32_decoded converted value
+ * @return NO_ERROR or INVALID_VALUE
+ */
+typedef Teleinfo::EError (*FieldDecoder)(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded);
+
+/**
+ * Teleinfo field defined according to
+ * http://norm.edf.fr/pdf/HN44S812emeeditionMars2007.pdf
+ */
+struct FieldDescriptor{
+	/** packed field label - refer TeleinfoLabels */
+	uint64_t _u64_label;
+	/** number of field data bytes */
+	uint8_t _u8_nbBytes;
+	EValueType _e_type;
+	/** NULL for VALUE_STRING */
+	FieldDecoder _p_decoder;
+	/** value offset in TeleinfoFrame */
+	uint16_t _u16_offset;
+	/** bit set in changed mask */
+	ETeleinfoField _e_field;
 };
 
 /*************************************
  * Static definitions
  *************************************/
-const char* Teleinfo::ADC0 = "ADC0";
+static Teleinfo::EError decodeNumber(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded);
+static Teleinfo::EError decodeOptTar(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded);
+static Teleinfo::EError decodePTEC(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded);
+static Teleinfo::EError decodeTempoColor(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded);
+static Teleinfo::EError decodeChar(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded);
+static Teleinfo::EError decodeHex(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded);
 
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__)
+#error "decodeNumber() expects a little endian target"
+#endif
 
-const struct OPTarMapping Teleinfo::OPT_TAR[NB_OPT_TAR] =
+#define FIELD_OFFSET(member) ((uint16_t) offsetof(TeleinfoFrame, member))
+
+/** historic mode fields descriptors */
+static constexpr FieldDescriptor FIELDS[] =
+{
+	/** label                          length                                     type           decoder        storage                       field */
+	{TeleinfoLabels::pack("ADCO"),     TELEREPORT_HUB_ADDR_LENGTH,                VALUE_STRING,  NULL,          FIELD_OFFSET(_as8_hubAddr),   ADCO_FIELD},
+	{TeleinfoLabels::pack("MOTDETAT"), TeleinfoFrame::MOD_ETAT_LENGTH,            VALUE_STRING,  NULL,          FIELD_OFFSET(_as8_modEtat),   MOTDETAT_FIELD},
+	{TeleinfoLabels::pack("OPTARIF"),  TeleinfoFrame::OP_TAR_LENGTH,              VALUE_U8,      decodeOptTar,  FIELD_OFFSET(_u8_optTar),     OPTARIF_FIELD},
+	{TeleinfoLabels::pack("ISOUSC"),   TeleinfoFrame::INT_LENGTH,                 VALUE_U16,     decodeNumber,  FIELD_OFFSET(_u16_souscInt),  ISOUSC_FIELD},
+	{TeleinfoLabels::pack("IINST"),    TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_u16_instInt),   IINST_FIELD},
+	{TeleinfoLabels::pack("IMAX"),     TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_u16_maxInt),    IMAX_FIELD},
+	{TeleinfoLabels::pack("HCHC"),     TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_hcIndex),   HCHC_FIELD},
+	{TeleinfoLabels::pack("HCHP"),     TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_hpIndex),   HCHP_FIELD},
+	{TeleinfoLabels::pack("BASE"),     TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_baseIndex), BASE_FIELD},
+	{TeleinfoLabels::pack("EJPHN"),    TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_ejpHNIndex),  EJPHN_FIELD},
+	{TeleinfoLabels::pack("EJPHPM"),   TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_ejpHPMIndex), EJPHPM_FIELD},
+	{TeleinfoLabels::pack("BBRHCJB"),  TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_bbrHCJBIndex), BBRHCJB_FIELD},
+	{TeleinfoLabels::pack("BBRHPJB"),  TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_bbrHPJBIndex), BBRHPJB_FIELD},
+	{TeleinfoLabels::pack("BBRHCJW"),  TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_bbrHCJWIndex), BBRHCJW_FIELD},
+	{TeleinfoLabels::pack("BBRHPJW"),  TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_bbrHPJWIndex), BBRHPJW_FIELD},
+	{TeleinfoLabels::pack("BBRHCJR"),  TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_bbrHCJRIndex), BBRHCJR_FIELD},
+	{TeleinfoLabels::pack("BBRHPJR"),  TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_bbrHPJRIndex), BBRHPJR_FIELD},
+	{TeleinfoLabels::pack("DEMAIN"),   TeleinfoFrame::COLOR_LENGTH,               VALUE_U8,      decodeTempoColor, FIELD_OFFSET(_u8_tomorrowColor), DEMAIN_FIELD},
+	{TeleinfoLabels::pack("GAZ"),      TeleinfoFrame::GAZ_INDEX_LENGTH,           VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_gazIndex),  GAZ_FIELD},
+	{TeleinfoLabels::pack("PEJP"),     TeleinfoFrame::PTEC_MESS_LENGTH,           VALUE_U8,      decodeNumber,  FIELD_OFFSET(_u8_ejpMess),    PEJP_FIELD},
+	{TeleinfoLabels::pack("PTEC"),     TeleinfoFrame::PTEC_LENGTH,                VALUE_U8,      decodePTEC,    FIELD_OFFSET(_u8_currTar),    PTEC_FIELD},
+	{TeleinfoLabels::pack("PAPP"),     TeleinfoFrame::POWER_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_appPower),  PAPP_FIELD},
+	{TeleinfoLabels::pack("HHPHC"),    TeleinfoFrame::HHPHC_LENGTH,               VALUE_CHAR,    decodeChar,    FIELD_OFFSET(_s8_hhphc),      HHPHC_FIELD},
+	/** three-phase */
+	{TeleinfoLabels::pack("IINST1"),   TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_phases[0]._u16_instInt), PHASE_IINST_FIELD},
+	{TeleinfoLabels::pack("IINST2"),   TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_phases[1]._u16_instInt), PHASE_IINST_FIELD},
+	{TeleinfoLabels::pack("IINST3"),   TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_phases[2]._u16_instInt), PHASE_IINST_FIELD},
+	{TeleinfoLabels::pack("IMAX1"),    TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_phases[0]._u16_maxInt),  PHASE_IMAX_FIELD},
+	{TeleinfoLabels::pack("IMAX2"),    TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_phases[1]._u16_maxInt),  PHASE_IMAX_FIELD},
+	{TeleinfoLabels::pack("IMAX3"),    TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_phases[2]._u16_maxInt),  PHASE_IMAX_FIELD},
+	{TeleinfoLabels::pack("ADIR1"),    TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_phases[0]._u16_overInt), ADIR_FIELD},
+	{TeleinfoLabels::pack("ADIR2"),    TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_phases[1]._u16_overInt), ADIR_FIELD},
+	{TeleinfoLabels::pack("ADIR3"),    TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_phases[2]._u16_overInt), ADIR_FIELD},
+	{TeleinfoLabels::pack("PMAX"),     TeleinfoFrame::MAX_POWER_LENGTH,           VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_maxPower),  PMAX_FIELD},
+	{TeleinfoLabels::pack("PPOT"),     TeleinfoFrame::POTENTIALS_LENGTH,          VALUE_U8,      decodeHex,     FIELD_OFFSET(_u8_potentials), PPOT_FIELD},
+};
+
+/** standard mode fields descriptors - fields having an historic equivalent share its storage and field */
+static constexpr FieldDescriptor STANDARD_FIELDS[] =
+{
+	/** label                          length                                     type           decoder        storage                         field */
+	{TeleinfoLabels::pack("ADSC"),     TELEREPORT_HUB_ADDR_LENGTH,                VALUE_STRING,  NULL,          FIELD_OFFSET(_as8_hubAddr),     ADCO_FIELD},
+	{TeleinfoLabels::pack("NGTF"),     TeleinfoFrame::TARIFF_NAME_LENGTH,         VALUE_STRING,  NULL,          FIELD_OFFSET(_as8_tariffName),  NGTF_FIELD},
+	{TeleinfoLabels::pack("LTARF"),    TeleinfoFrame::TARIFF_NAME_LENGTH,         VALUE_STRING,  NULL,          FIELD_OFFSET(_as8_tariffLabel), LTARF_FIELD},
+	{TeleinfoLabels::pack("EAST"),     TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_baseIndex),   BASE_FIELD},
+	{TeleinfoLabels::pack("EASF01"),   TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_hcIndex),     HCHC_FIELD},
+	{TeleinfoLabels::pack("EASF02"),   TeleinfoFrame::INDEX_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_hpIndex),     HCHP_FIELD},
+	{TeleinfoLabels::pack("IRMS1"),    TeleinfoFrame::CURR_INT_LENGTH,            VALUE_U16,     decodeNumber,  FIELD_OFFSET(_u16_instInt),     IINST_FIELD},
+	{TeleinfoLabels::pack("URMS1"),    TeleinfoFrame::VOLTAGE_LENGTH,             VALUE_U16,     decodeNumber,  FIELD_OFFSET(_u16_rmsVoltage),  URMS1_FIELD},
+	{TeleinfoLabels::pack("PREF"),     TeleinfoFrame::REF_POWER_LENGTH,           VALUE_U8,      decodeNumber,  FIELD_OFFSET(_u8_refPower),     PREF_FIELD},
+	{TeleinfoLabels::pack("SINSTS"),   TeleinfoFrame::POWER_LENGTH,               VALUE_U32,     decodeNumber,  FIELD_OFFSET(_u32_appPower),    PAPP_FIELD},
+	{TeleinfoLabels::pack("STGE"),     TeleinfoFrame::STATUS_LENGTH,              VALUE_U32,     decodeHex,     FIELD_OFFSET(_u32_status),      STGE_FIELD},
+	{TeleinfoLabels::pack("NTARF"),    TeleinfoFrame::TARIFF_INDEX_LENGTH,        VALUE_U8,      decodeNumber,  FIELD_OFFSET(_u8_tariffIndex),  NTARF_FIELD},
+};
+
+static const uint8_t NB_FIELDS = sizeof(FIELDS) / sizeof(FIELDS[0]);
+static const uint8_t NB_STANDARD_FIELDS = sizeof(STANDARD_FIELDS) / sizeof(STANDARD_FIELDS[0]);
+
+/** hash multipliers found offline for each labels table */
+static const uint32_t FIELDS_HASH_MULT = 0xB07338F1;
+static const uint32_t STANDARD_FIELDS_HASH_MULT = 0x6B153E7B;
+
+static_assert(TeleinfoLabels::isPerfect(FIELDS, NB_FIELDS, FIELDS_HASH_MULT), "historic label hash collision - FIELDS_HASH_MULT must be changed");
+static_assert(TeleinfoLabels::isPerfect(STANDARD_FIELDS, NB_STANDARD_FIELDS, STANDARD_FIELDS_HASH_MULT), "standard label hash collision - STANDARD_FIELDS_HASH_MULT must be changed");
+
+/** label dispatch tables - slot to field descriptor */
+static constexpr uint8_t FIELD_SLOTS[1 << TeleinfoLabels::HASH_BITS] = TELEINFO_LABEL_SLOTS(FIELDS, NB_FIELDS, FIELDS_HASH_MULT);
+static constexpr uint8_t STANDARD_FIELD_SLOTS[1 << TeleinfoLabels::HASH_BITS] = TELEINFO_LABEL_SLOTS(STANDARD_FIELDS, NB_STANDARD_FIELDS, STANDARD_FIELDS_HASH_MULT);
+
+#define MAPPED_VALUE(value) ((uint32_t) TeleinfoLabels::pack(value))
+
+/** Tempo OPTARIF is "BBR" followed by tariff program, decoded apart */
+static const struct ValueMapping OPT_TAR[] =
 {
-		{"BASE"  , BASE_TAR},
-		{"HC.."  , HC_TAR},
-		{"EJP."  , EJP_TAR},
+		{MAPPED_VALUE("BASE"), BASE_TAR},
+		{MAPPED_VALUE("HC.."), HC_TAR},
+		{MAPPED_VALUE("EJP."), EJP_TAR},
 };
+static const uint32_t TEMPO_OPT_TAR_PREFIX = MAPPED_VALUE("BBR");
 
-const struct PTECMapping Teleinfo::PTEC[NB_PTEC] =
+static const struct ValueMapping PTEC[NB_PTEC] =
 {
-		{"TH.."  , TH},
-		{"HC.."  , HC},
-		{"HP.."  , HP},
-		{"HN.."  , HN},
-		{"PM.."  , PM},
+		{MAPPED_VALUE("TH.."), TH},
+		{MAPPED_VALUE("HC.."), HC},
+		{MAPPED_VALUE("HP.."), HP},
+		{MAPPED_VALUE("HN.."), HN},
+		{MAPPED_VALUE("PM.."), PM},
+		{MAPPED_VALUE("HCJB"), HCJB},
+		{MAPPED_VALUE("HPJB"), HPJB},
+		{MAPPED_VALUE("HCJW"), HCJW},
+		{MAPPED_VALUE("HPJW"), HPJW},
+		{MAPPED_VALUE("HCJR"), HCJR},
+		{MAPPED_VALUE("HPJR"), HPJR},
+};
+
+static const struct ValueMapping TEMPO_COLOR[NB_TEMPO_COLOR] =
+{
+		{MAPPED_VALUE("----"), TEMPO_NO_COLOR},
+		{MAPPED_VALUE("BLEU"), TEMPO_BLUE},
+		{MAPPED_VALUE("BLAN"), TEMPO_WHITE},
+		{MAPPED_VALUE("ROUG"), TEMPO_RED},
 };
 
 
@@ -69,524 +206,673 @@ const struct PTECMapping Teleinfo::PTEC[NB_PTEC] =
 Teleinfo::Teleinfo(Stream* arg_p_stream) :
 	_p_infoStream(arg_p_stream),
 	_continueRead(false),
-	_p_teleinfoListener(NULL)
+	_u8_nbListeners(0),
+	_e_state(WAIT_FRAME_START),
+	_u8_labelLength(0),
+	_u64_labelKey(0),
+	_u8_separator(SPACE),
+	_u8_field(TeleinfoLabels::NO_ENTRY),
+	_u8_dataLength(0),
+	_u8_checksum(0),
+	_e_mode(TIC_MODE_UNKNOWN),
+	_u32_nbValidGroups(0),
+	_changedMask(0),
+	_receivedMask(0),
+	_seenMask(0),
+	_b_shortFrame(false),
+	_b_partialFrame(false),
+	_u32_frameParseUs(0),
+	_u32_frameEndMs(0),
+	_b_frameEnded(false)
 {
-	_telereportHubAddr._fieldValue = (char*)malloc(TELEREPORT_HUB_ADDR_LENGTH + 1);
-	_modEtat._fieldValue             = (char*)malloc(MOD_ETAT_LENGTH + 1);
+	memset(&_frame, 0, sizeof(_frame));
+	memset(&_stats, 0, sizeof(_stats));
+	memset(_au32_fieldUpdateMs, 0, sizeof(_au32_fieldUpdateMs));
+	_frame._u8_optTar = OPT_TAR_OUT_OF_ENUM;
+	_frame._u8_currTar = PTEC_OUT_OF_ENUM;
+	_frame._u8_tomorrowColor = TEMPO_COLOR_OUT_OF_ENUM;
+	_frame._s8_hhphc = '0';
 }
 
 Teleinfo::~Teleinfo() {
-	if(_telereportHubAddr._fieldValue)
-	{
-		free(_telereportHubAddr._fieldValue);
-	}
-
-	if(_modEtat._fieldValue)
-	{
-		free(_modEtat._fieldValue);
-	}
 }
 
 void Teleinfo::startRead(void)
 {
-	_continueRead = true;
-	uint8_t loc_u8_buff[1] = {0};
+	const uint8_t READ_WAIT_MS = 10;
 	Teleinfo::EError loc_e_error = NO_ERROR;
 
+	_continueRead = true;
 	while(_continueRead)
 	{
-		loc_e_error = readBytes(loc_u8_buff, 1);
-		if(loc_e_error < NO_ERROR)
-		{
-			LOG_ERROR("Cannot read byte - err = %d", loc_e_error);
-			continue;
-		}
-
-		if(loc_u8_buff[0] == START_TEXT)
+		if(_p_infoStream->available())
 		{
-			loc_e_error = readInfoGroups();
-			if(loc_e_error != NO_ERROR)
+			loc_e_error = feed((uint8_t) _p_infoStream->read());
+			if(loc_e_error < NO_ERROR)
 			{
 				LOG_ERROR("Cannot read information groups - err = %d", loc_e_error);
 			}
-			else
-			{
-
-				LOG_DEBUG_LN("Info groups successfully read");
-			}
 		}
-		else if(loc_u8_buff[0] == END_TEXT)
+		else
 		{
-			LOG_DEBUG_LN("End of frame");
+			delay(READ_WAIT_MS);
 		}
-		else if(loc_u8_buff[0] == END_OF_TEXT)
+	}
+}
+
+Teleinfo::EError Teleinfo::feed(const uint8_t* arg_au8_bytes, size_t arg_u32_nbBytes)
+{
+	Teleinfo::EError loc_e_error = NO_ERROR;
+	Teleinfo::EError loc_e_ret = NO_ERROR;
+
+	for(size_t loc_u32_index = 0; loc_u32_index < arg_u32_nbBytes; loc_u32_index++)
+	{
+		loc_e_error = feed(arg_au8_bytes[loc_u32_index]);
+		if(loc_e_error == FRAME_AVAILABLE)
 		{
-			LOG_INFO_LN("End of text");
+			loc_e_ret = FRAME_AVAILABLE;
 		}
-		else
+		else if(loc_e_error < NO_ERROR && loc_e_ret != FRAME_AVAILABLE)
 		{
-			LOG_DEBUG("Cannot handle byte %x in frame reading", loc_u8_buff[0]);
+			loc_e_ret = loc_e_error;
 		}
 	}
+	return loc_e_ret;
 }
 
-Teleinfo::EError Teleinfo::readInfoGroups(void)
+Teleinfo::EError Teleinfo::feed(uint8_t arg_u8_byte)
 {
-	uint8_t loc_u8_buff[1] = {0};
-	Teleinfo::EError loc_e_error = NO_ERROR;
+	/** transmission on 7 bits - LSB*/
+	arg_u8_byte &= 0x7F;
 
-	while(_continueRead)
+	/** a new frame can start at any time, previous one is then incomplete */
+	if(arg_u8_byte == START_TEXT)
 	{
-		loc_e_error = readBytes(loc_u8_buff, 1);
-		if(loc_e_error < NO_ERROR)
+		bool loc_b_groupInterrupted = (_e_state == READ_LABEL || _e_state == READ_DATA);
+		bool loc_b_frameInterrupted = (_e_state != WAIT_FRAME_START);
+
+		if(loc_b_frameInterrupted)
+		{
+			LOG_DEBUG_LN("Frame interrupted by a new frame");
+		}
+		_e_state = WAIT_GROUP_START;
+		_b_shortFrame = false;
+		_u32_frameParseUs = 0;
+		/** groups of interrupted frame not received again in new one */
+		_receivedMask = 0;
+		/**
+		 * values changed in interrupted frame are notified with new one : it is
+		 * partial, whether STX cut a group or ETX was lost between groups. Groups
+		 * already skipped keep it partial
+		 */
+		_b_partialFrame = loc_b_frameInterrupted || _b_partialFrame;
+		if(loc_b_groupInterrupted)
+		{
+			LOG_ERROR("Group not terminated - err = %d", INVALID_READ);
+			countError(INVALID_READ);
+		}
+		if(_b_frameEnded)
+		{
+			uint32_t loc_u32_gapMs = millis() - _u32_frameEndMs;
+			_stats._frameGapMs.add(loc_u32_gapMs);
+			if(loc_u32_gapMs > READ_TIMEOUT_MS)
+			{
+				_stats._u32_nbReadTimeouts++;
+			}
+			_b_frameEnded = false;
+		}
+		return loc_b_groupInterrupted ? INVALID_READ : NO_ERROR;
+	}
+	/** transmission interrupted - p12 - http://norm.edf.fr/pdf/HN44S812emeeditionMars2007.pdf */
+	else if(arg_u8_byte == END_OF_TEXT)
+	{
+		LOG_INFO_LN("End of text");
+		_e_state = WAIT_FRAME_START;
+		return NO_ERROR;
+	}
+
+	/** LF and ETX never appear inside a group, even as CRC : parser resyncs on them */
+	if(_e_state != WAIT_FRAME_START && (arg_u8_byte == LINE_FEED || arg_u8_byte == END_TEXT))
+	{
+		Teleinfo::EError loc_e_error = NO_ERROR;
+
+		if(_e_state == READ_LABEL || _e_state == READ_DATA)
 		{
-			LOG_ERROR("Cannot read byte - err = %d", loc_e_error);
-			return INVALID_READ;
+			LOG_ERROR("Group not terminated - err = %d", INVALID_READ);
+			countError(INVALID_READ);
+			_b_partialFrame = true;
+			loc_e_error = INVALID_READ;
 		}
 
-		if(loc_u8_buff[0] == LINE_FEED)
+		if(arg_u8_byte == LINE_FEED)
 		{
-			loc_e_error = readInfoGroup();
-			if(loc_e_error < NO_ERROR)
+			_u8_labelLength = 0;
+			_u64_labelKey = 0;
+			_u8_dataLength = 0;
+			_u8_checksum = 0;
+			_e_state = READ_LABEL;
+			return loc_e_error;
+		}
+		LOG_DEBUG_LN("End of frame");
+		_e_state = WAIT_FRAME_START;
+		notifyFrame();
+		return FRAME_AVAILABLE;
+	}
+
+	switch(_e_state)
+	{
+	case WAIT_FRAME_START :
+		/** wait for STX */
+		return NO_ERROR;
+
+	case WAIT_GROUP_START :
+		LOG_ERROR("Invalid byte %x received, %x or %x expected", arg_u8_byte, LINE_FEED, END_TEXT);
+		return skipGroup(INVALID_READ);
+
+	case READ_LABEL :
+		/** separator gives mode : SPACE in historic mode, HTAB in standard mode */
+		if(arg_u8_byte == SPACE || arg_u8_byte == HTAB)
+		{
+			_as8_label[_u8_labelLength] = '\0';
+			_u8_separator = arg_u8_byte;
+			/** label separator is part of CRC - p11 - http://norm.edf.fr/pdf/HN44S812emeeditionMars2007.pdf */
+			_u8_checksum += arg_u8_byte;
+			if(_u8_labelLength > TeleinfoLabels::KEY_MAX_LENGTH)
 			{
-				LOG_ERROR("Cannot read info group - err = %d", loc_e_error);
-				return INVALID_READ;
+				_u8_field = TeleinfoLabels::NO_ENTRY;
 			}
+			else if(_u8_separator == HTAB)
+			{
+				_u8_field = TeleinfoLabels::lookup(STANDARD_FIELDS, STANDARD_FIELD_SLOTS, STANDARD_FIELDS_HASH_MULT, _u64_labelKey);
+			}
+			else
+			{
+				_u8_field = TeleinfoLabels::lookup(FIELDS, FIELD_SLOTS, FIELDS_HASH_MULT, _u64_labelKey);
+			}
+
+			/** standard mode sends much more groups than handled ones, some of them too long to be buffered */
+			if(_u8_field == TeleinfoLabels::NO_ENTRY && _u8_separator == HTAB)
+			{
+				LOG_DEBUG_LN("%s group skipped", _as8_label);
+				_stats._u32_nbUnhandledGroups++;
+				_e_state = SKIP_GROUP;
+			}
+			else
+			{
+				_e_state = READ_DATA;
+			}
+			return NO_ERROR;
 		}
-		else if(loc_u8_buff[0] == END_TEXT)
+		/** keep 1 byte for null char */
+		else if(_u8_labelLength < LABEL_MAX_LENGTH - 1)
 		{
-			LOG_DEBUG_LN("End of frame - no more info groups to read");
+			/** label packed on reception, no string compare needed to dispatch it */
+			if(_u8_labelLength < TeleinfoLabels::KEY_MAX_LENGTH)
+			{
+				_u64_labelKey |= ((uint64_t) arg_u8_byte) << (8 * _u8_labelLength);
+			}
+			_as8_label[_u8_labelLength++] = arg_u8_byte;
+			_u8_checksum += arg_u8_byte;
 			return NO_ERROR;
 		}
-		else if(loc_u8_buff[0] == END_OF_TEXT)
+		LOG_ERROR("Cannot read group label - err = %d", INVALID_LENGTH);
+		return skipGroup(INVALID_LENGTH);
+
+	case READ_DATA :
+		if(arg_u8_byte == CARRIAGE_RET)
 		{
-			LOG_INFO_LN("End of text - no more info groups to read");
-			return NO_ERROR;
+			uint32_t loc_u32_startUs = micros();
+			Teleinfo::EError loc_e_error = endGroup();
+			_u32_frameParseUs += micros() - loc_u32_startUs;
+			return loc_e_error;
 		}
-		else
+		else if(_u8_dataLength < DATA_MAX_LENGTH)
 		{
-			//LOG_ERROR("Invalid byte %x received, %x or %x expected", loc_u8_buff[0], LINE_FEED, END_OF_TEXT);
-			return INVALID_READ;
+			_au8_data[_u8_dataLength++] = arg_u8_byte;
+			/** CRC and trailing separator removed on group end if not part of CRC */
+			_u8_checksum += arg_u8_byte;
+			return NO_ERROR;
 		}
+		LOG_ERROR("Cannot read group value - err = %d", INVALID_LENGTH);
+		return skipGroup(INVALID_LENGTH);
+
+	case SKIP_GROUP :
+		/** wait for LF or ETX */
+		return NO_ERROR;
+
+	default :
+		break;
 	}
 
-	return NO_ERROR;
+	/** drop current frame */
+	_e_state = WAIT_FRAME_START;
+	return INVALID_READ;
 }
 
-Teleinfo::EError Teleinfo::readInfoGroup(void)
+ETeleinfoField Teleinfo::lookupLabel(uint64_t arg_u64_labelKey, ETicMode arg_e_mode)
 {
-	uint8_t loc_u8_buff[1] = {0};
-	char loc_s8_label[LABEL_MAX_LENGTH] = {0};
-	uint8_t loc_au8_value[VALUE_MAX_LENGTH] = {0};
-	uint8_t loc_u8_valueLength = 0;
-	Teleinfo::EError loc_e_error = NO_ERROR;
+	uint8_t loc_u8_entry;
 
-	loc_e_error = readGroupLabel(loc_s8_label);
-	if(loc_e_error < NO_ERROR)
+	if(arg_e_mode == TIC_MODE_STANDARD)
 	{
-		LOG_ERROR("Cannot read group label - err = %d", loc_e_error);
-		return INVALID_READ;
+		loc_u8_entry = TeleinfoLabels::lookup(STANDARD_FIELDS, STANDARD_FIELD_SLOTS, STANDARD_FIELDS_HASH_MULT, arg_u64_labelKey);
+		return (loc_u8_entry == TeleinfoLabels::NO_ENTRY) ? NB_TELEINFO_FIELDS : STANDARD_FIELDS[loc_u8_entry]._e_field;
 	}
+	loc_u8_entry = TeleinfoLabels::lookup(FIELDS, FIELD_SLOTS, FIELDS_HASH_MULT, arg_u64_labelKey);
+	return (loc_u8_entry == TeleinfoLabels::NO_ENTRY) ? NB_TELEINFO_FIELDS : FIELDS[loc_u8_entry]._e_field;
+}
 
-	loc_e_error = readGroupValue(loc_au8_value, &loc_u8_valueLength);
-	if(loc_e_error < NO_ERROR)
-	{
-		LOG_ERROR("Cannot read group value - err = %d", loc_e_error);
-		return INVALID_READ;
-	}
+Teleinfo::EError Teleinfo::decodeDecimal(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded)
+{
+	return decodeNumber(arg_au8_value, arg_u8_valueLen, arg_p_u32_decoded);
+}
 
-	/** now check if read group has a valid CRC */
-	loc_e_error = readBytes(loc_u8_buff, 1);
+void Teleinfo::resetParser(void)
+{
+	_e_state = WAIT_FRAME_START;
+}
 
-	if(loc_e_error < NO_ERROR)
-	{
-		LOG_ERROR("Cannot read CRC - err = %d", loc_e_error);
-		return INVALID_READ;
-	}
+void Teleinfo::resetStats(void)
+{
+	memset(&_stats, 0, sizeof(_stats));
+}
 
-	if(!isCRCOK(loc_s8_label, loc_au8_value, loc_u8_valueLength, loc_u8_buff[0]))
+void Teleinfo::countError(EError arg_e_error)
+{
+	switch(arg_e_error)
 	{
-		LOG_ERROR("invalid CRC");
-		return INVALID_CRC;
+	case INVALID_CRC :
+		_stats._u32_nbCRCErrors++;
+		break;
+	case INVALID_LENGTH :
+		_stats._u32_nbLengthErrors++;
+		break;
+	case INVALID_VALUE :
+		_stats._u32_nbValueErrors++;
+		break;
+	default :
+		_stats._u32_nbReadErrors++;
+		break;
 	}
+}
+
+Teleinfo::EError Teleinfo::skipGroup(EError arg_e_error)
+{
+	countError(arg_e_error);
+	_b_partialFrame = true;
+	_e_state = SKIP_GROUP;
+	return arg_e_error;
+}
 
-	/** now check if read group has a valid CRC */
-	loc_e_error = readBytes(loc_u8_buff, 1);
+Teleinfo::EError Teleinfo::endGroup(void)
+{
+	Teleinfo::EError loc_e_error = NO_ERROR;
+	uint8_t loc_u8_valueStart = 0;
+	uint8_t loc_u8_valueEnd = 0;
+	uint8_t loc_u8_crc = 0;
 
-	if(loc_e_error < NO_ERROR)
+	/** data is [timestamp separator] value separator CRC - CRC can be any char, even a space */
+	if(_u8_dataLength < 2 || _au8_data[_u8_dataLength - 2] != _u8_separator)
 	{
-		LOG_ERROR("Cannot read last group byte - err = %d", loc_e_error);
-		return INVALID_READ;
+		LOG_ERROR("Invalid group %s", _as8_label);
+		return skipGroup(INVALID_READ);
 	}
+	loc_u8_valueEnd = _u8_dataLength - 2;
 
-	if(loc_u8_buff[0] != CARRIAGE_RET)
+	/** checksum accumulated on reception covers label, separators and CRC : remove CRC,
+	 * and separator before CRC which is part of CRC in standard mode only */
+	loc_u8_crc = _au8_data[_u8_dataLength - 1];
+	_u8_checksum -= loc_u8_crc;
+	if(_u8_separator == SPACE)
 	{
-		LOG_ERROR("Invalid byte %x received, %x expected", loc_u8_buff[0], CARRIAGE_RET);
-		return INVALID_READ;
+		_u8_checksum -= SPACE;
 	}
-	else
+	if(((_u8_checksum & 0x3F) + 0x20) != loc_u8_crc)
 	{
-		loc_e_error = parseGroup(loc_s8_label, loc_au8_value, loc_u8_valueLength);
-		if(loc_e_error < NO_ERROR)
-		{
-			LOG_ERROR("Cannot parse group %s - err = %d", loc_s8_label, loc_e_error);
-		}
-		return loc_e_error;
+		LOG_ERROR("invalid CRC");
+		return skipGroup(INVALID_CRC);
 	}
-}
-
 
-Teleinfo::EError Teleinfo::readGroupLabel(char arg_as8_label[LABEL_MAX_LENGTH])
-{
-	uint8_t loc_u8_buff[1] = {0};
-	Teleinfo::EError loc_e_error = NO_ERROR;
-	uint8_t loc_u8_index = 0;
+	_e_mode = (_u8_separator == HTAB) ? TIC_MODE_STANDARD : TIC_MODE_HISTORIC;
+	_u32_nbValidGroups++;
 
-	for(loc_u8_index = 0; loc_u8_index < LABEL_MAX_LENGTH; loc_u8_index++)
+	/** timestamped group - standard mode only, timestamp not used */
+	if(_u8_separator == HTAB)
 	{
-		loc_e_error = readBytes(loc_u8_buff, 1);
-		if(loc_e_error < NO_ERROR)
-		{
-			LOG_ERROR("Cannot read byte - err = %d", loc_e_error);
-			return INVALID_READ;
-		}
-		if(loc_u8_buff[0] != SPACE)
+		for(uint8_t loc_u8_index = 0; loc_u8_index < loc_u8_valueEnd; loc_u8_index++)
 		{
-			arg_as8_label[loc_u8_index] = loc_u8_buff[0];
-		}
-		else
-		{
-			arg_as8_label[loc_u8_index] = '\0';
-			return NO_ERROR;
+			if(_au8_data[loc_u8_index] == HTAB)
+			{
+				loc_u8_valueStart = loc_u8_index + 1;
+				break;
+			}
 		}
 	}
+	/** replaces separator */
+	_au8_data[loc_u8_valueEnd] = '\0';
 
-	return INVALID_LENGTH;
+	loc_e_error = parseGroup(_u8_field, &_au8_data[loc_u8_valueStart], loc_u8_valueEnd - loc_u8_valueStart);
+	/** a group not handled does not invalidate frame */
+	if(loc_e_error == NOT_HANDLED_GROUP)
+	{
+		_stats._u32_nbUnhandledGroups++;
+		_e_state = WAIT_GROUP_START;
+		return NOT_HANDLED_GROUP;
+	}
+	else if(loc_e_error < NO_ERROR)
+	{
+		LOG_ERROR("Cannot parse group %s - err = %d", _as8_label, loc_e_error);
+		return skipGroup(loc_e_error);
+	}
+
+	_stats._u32_nbGroups++;
+	_e_state = WAIT_GROUP_START;
+	return GROUP_AVAILABLE;
 }
 
-Teleinfo::EError Teleinfo::readGroupValue(uint8_t arg_au8_value[VALUE_MAX_LENGTH], uint8_t* arg_u8_value_length)
+Teleinfo::EError Teleinfo::parseGroup(uint8_t arg_u8_field, uint8_t * arg_u8_value, uint8_t arg_u8_valueLen)
 {
-	uint8_t loc_u8_buff[1] = {0};
 	Teleinfo::EError loc_e_error = NO_ERROR;
-	*arg_u8_value_length = 0;
+	uint32_t loc_u32_decoded = 0;
+	bool loc_b_changed = false;
 
-	for(*arg_u8_value_length = 0; *arg_u8_value_length < VALUE_MAX_LENGTH; (*arg_u8_value_length)++)
+	if(arg_u8_field == TeleinfoLabels::NO_ENTRY)
 	{
-		loc_e_error = readBytes(loc_u8_buff, 1);
-		if(loc_e_error < NO_ERROR)
-		{
-			LOG_ERROR("Cannot read byte - err = %d", loc_e_error);
-			return INVALID_READ;
-		}
-
-		if(loc_u8_buff[0] != SPACE)
-		{
-			arg_au8_value[*arg_u8_value_length] = loc_u8_buff[0];
-		}
-		else
-		{
-			return NO_ERROR;
-		}
+		/** not an error : logging each of them would flood serial line */
+		LOG_DEBUG_LN("%s group not handled", _as8_label);
+		return NOT_HANDLED_GROUP;
 	}
 
-	return INVALID_LENGTH;
-}
+	const FieldDescriptor& loc_field = (_u8_separator == HTAB) ? STANDARD_FIELDS[arg_u8_field] : FIELDS[arg_u8_field];
+	uint8_t* loc_p_u8_storage = ((uint8_t*) &_frame) + loc_field._u16_offset;
 
-Teleinfo::EError Teleinfo::parseGroup(char * arg_s8_label, uint8_t * arg_u8_value, uint8_t arg_u8_valueLen)
-{
-	/** Teleinfo HUB address -ADC0 */
-	if(strcmp(_telereportHubAddr._as8_name, arg_s8_label) == 0)
+	if(arg_u8_valueLen != loc_field._u8_nbBytes)
 	{
-		if(arg_u8_valueLen != _telereportHubAddr._u8_nbBytes)
-		{
-			return INVALID_LENGTH;
-		}
+		return INVALID_LENGTH;
+	}
 
-		if(strcmp(_telereportHubAddr._fieldValue, (char*) arg_u8_value) != 0)
+	/**
+	 * fast path for ADIRn sent in bursts of short frames while a phase is
+	 * overloaded : always notified, nothing logged
+	 */
+	if(loc_field._e_field == ADIR_FIELD)
+	{
+		loc_e_error = decodeNumber(arg_u8_value, arg_u8_valueLen, &loc_u32_decoded);
+		if(loc_e_error < NO_ERROR)
 		{
-			/** +1 for null terminated string */
-			strncpy(_telereportHubAddr._fieldValue, (const char*) arg_u8_value, TELEREPORT_HUB_ADDR_LENGTH + 1);
-			if(_p_teleinfoListener) {_p_teleinfoListener->hubAddrChanged(_telereportHubAddr._fieldValue);}
-			LOG_DEBUG_LN("%s = %s", _telereportHubAddr._as8_name, _telereportHubAddr._fieldValue);
+			return loc_e_error;
 		}
+		*((uint16_t*) loc_p_u8_storage) = (uint16_t) loc_u32_decoded;
+		_changedMask |= teleinfoFieldMask(ADIR_FIELD);
+		_receivedMask |= teleinfoFieldMask(ADIR_FIELD);
+		_b_shortFrame = true;
 		return NO_ERROR;
 	}
-	/** Power meter state - MODETAT */
-	else if(strcmp(_modEtat._as8_name, arg_s8_label) == 0)
+
+	if(loc_field._e_type == VALUE_STRING)
 	{
-		if(arg_u8_valueLen != _modEtat._u8_nbBytes)
+		loc_b_changed = memcmp(loc_p_u8_storage, arg_u8_value, arg_u8_valueLen) != 0;
+		if(loc_b_changed)
 		{
-			return INVALID_LENGTH;
+			/** +1 for null char */
+			memcpy(loc_p_u8_storage, arg_u8_value, arg_u8_valueLen + 1);
 		}
-		/** +1 for null char */
-		if(strcmp(_modEtat._fieldValue, (char*) arg_u8_value) != 0)
-		{
-			strncpy(_modEtat._fieldValue, (const char*) arg_u8_value, arg_u8_valueLen + 1);
-			LOG_DEBUG_LN("%s = %s", _modEtat._as8_name, _modEtat._fieldValue);
-			if(_p_teleinfoListener) {_p_teleinfoListener->modEtatChanged(_modEtat._fieldValue);}
-		}
-		return NO_ERROR;
 	}
-	/** Price option selected - OPTRARIF */
-	else if(strcmp(_optTar._as8_name, arg_s8_label) == 0)
+	else
 	{
-		if(arg_u8_valueLen != _optTar._u8_nbBytes)
+		loc_e_error = loc_field._p_decoder(arg_u8_value, arg_u8_valueLen, &loc_u32_decoded);
+		if(loc_e_error < NO_ERROR)
 		{
-			return INVALID_LENGTH;
+			return loc_e_error;
 		}
 
-		for(uint8_t loc_u8_optIndex = 0; loc_u8_optIndex < NB_OPT_TAR; loc_u8_optIndex++)
+		switch(loc_field._e_type)
 		{
-			if(strcmp(OPT_TAR[loc_u8_optIndex]._teleinfoField, (const char*) arg_u8_value) == 0)
-			{
-				if(_optTar._fieldValue != OPT_TAR[loc_u8_optIndex]._e_Val)
-				{
-					_optTar._fieldValue = OPT_TAR[loc_u8_optIndex]._e_Val;
-					if(_p_teleinfoListener) {_p_teleinfoListener->optTarChanged(_optTar._fieldValue);}
-					LOG_INFO_LN("%s = %d", _optTar._as8_name, _optTar._fieldValue);
-				}
-				return NO_ERROR;
-			}
+		case VALUE_U8 :
+		case VALUE_CHAR :
+			loc_b_changed = *loc_p_u8_storage != (uint8_t) loc_u32_decoded;
+			*loc_p_u8_storage = (uint8_t) loc_u32_decoded;
+			break;
+		case VALUE_U16 :
+			loc_b_changed = *((uint16_t*) loc_p_u8_storage) != (uint16_t) loc_u32_decoded;
+			*((uint16_t*) loc_p_u8_storage) = (uint16_t) loc_u32_decoded;
+			break;
+		case VALUE_U32 :
+			loc_b_changed = *((uint32_t*) loc_p_u8_storage) != loc_u32_decoded;
+			*((uint32_t*) loc_p_u8_storage) = loc_u32_decoded;
+			break;
+		default :
+			break;
 		}
-		return INVALID_VALUE;
 	}
-	/** Subscribed intensity -ISOUSC */
-	else if(strcmp(_souscInt._as8_name, arg_s8_label) == 0)
+
+	_receivedMask |= teleinfoFieldMask(loc_field._e_field);
+	if(loc_b_changed)
 	{
-		if(arg_u8_valueLen != _souscInt._u8_nbBytes)
-		{
-			return INVALID_LENGTH;
-		}
-		if(_souscInt._fieldValue != atoi((const char*)arg_u8_value))
-		{
-			_souscInt._fieldValue = atoi((const char*)arg_u8_value);
-			if(_p_teleinfoListener) {_p_teleinfoListener->souscIntChanged(_souscInt._fieldValue);}
-			LOG_DEBUG_LN("%s = %dA", _souscInt._as8_name, _souscInt._fieldValue);
-		}
-		return NO_ERROR;
+		_changedMask |= teleinfoFieldMask(loc_field._e_field);
+		LOG_DEBUG_LN("%s = %s", _as8_label, arg_u8_value);
 	}
-	/** Current intensity -IINST */
-	else if(strcmp(_instInt._as8_name, arg_s8_label) == 0)
+	return NO_ERROR;
+}
+
+void Teleinfo::notifyFrame(void)
+{
+	_frame._b_shortFrame = _b_shortFrame;
+	_frame._b_partialFrame = _b_partialFrame;
+
+	_stats._u32_nbFrames++;
+	if(_b_partialFrame)
 	{
-		if(arg_u8_valueLen != _instInt._u8_nbBytes)
-		{
-			return INVALID_LENGTH;
-		}
-		if(_instInt._fieldValue != atoi((const char*)arg_u8_value))
-		{
-			_instInt._fieldValue = atoi((const char*)arg_u8_value);
-			if(_p_teleinfoListener) {_p_teleinfoListener->instIntChanged(_instInt._fieldValue);}
-			LOG_DEBUG_LN("%s = %dA", _instInt._as8_name, _instInt._fieldValue);
-		}
-		return NO_ERROR;
+		_stats._u32_nbPartialFrames++;
 	}
-	/** Max called Int -IMAX */
-	else if(strcmp(_maxInt._as8_name, arg_s8_label) == 0)
+	_stats._frameParseUs.add(_u32_frameParseUs);
+	_u32_frameEndMs = millis();
+	_b_frameEnded = true;
+	_b_partialFrame = false;
+
+	for(uint8_t loc_u8_field = 0; _receivedMask != 0; loc_u8_field++, _receivedMask >>= 1)
 	{
-		if(arg_u8_valueLen != _maxInt._u8_nbBytes)
-		{
-			return INVALID_LENGTH;
-		}
-		if(_maxInt._fieldValue != atoi((const char*)arg_u8_value))
+		if(_receivedMask & 1)
 		{
-			_maxInt._fieldValue = atoi((const char*)arg_u8_value);
-			if(_p_teleinfoListener) {_p_teleinfoListener->maxIntChanged(_maxInt._fieldValue);}
-			LOG_DEBUG_LN("%s = %dA", _maxInt._as8_name, _maxInt._fieldValue);
+			_au32_fieldUpdateMs[loc_u8_field] = _u32_frameEndMs;
+			_seenMask |= teleinfoFieldMask((ETeleinfoField) loc_u8_field);
 		}
-		return NO_ERROR;
 	}
-	/** HCHC index - HCHC */
-	else if(strcmp(_hcIndex._as8_name, arg_s8_label) == 0)
+
+	for(uint8_t loc_u8_index = 0; loc_u8_index < _u8_nbListeners; loc_u8_index++)
 	{
-		if(arg_u8_valueLen != _hcIndex._u8_nbBytes)
-		{
-			return INVALID_LENGTH;
-		}
-		if(_hcIndex._fieldValue != (uint32_t)atoi((const char*) arg_u8_value))
+		TeleinfoFieldMask loc_mask = _changedMask & _listeners[loc_u8_index]._interestMask;
+		if(loc_mask)
 		{
-			_hcIndex._fieldValue = atoi((const char*) arg_u8_value);
-			if(_p_teleinfoListener) {_p_teleinfoListener->hcIndexChanged(_hcIndex._fieldValue);}
-			LOG_DEBUG_LN("%s = %dWh", _hcIndex._as8_name, _hcIndex._fieldValue);
+			_listeners[loc_u8_index]._p_listener->onFrame(_frame, loc_mask);
 		}
-		return NO_ERROR;
 	}
-	/** Full hour index - HPHP*/
-	else if(strcmp(_hpIndex._as8_name, arg_s8_label) == 0)
+	_changedMask = 0;
+
+	/** ADIRn only valid in short frame they were received in, clearing notified with next frame */
+	if(_b_shortFrame)
 	{
-		if(arg_u8_valueLen != _hpIndex._u8_nbBytes)
-		{
-			return INVALID_LENGTH;
-		}
-		if(_hpIndex._fieldValue != (uint32_t)atoi((const char*) arg_u8_value))
+		for(uint8_t loc_u8_phase = 0; loc_u8_phase < TeleinfoFrame::NB_PHASES; loc_u8_phase++)
 		{
-			_hpIndex._fieldValue = atoi((const char*) arg_u8_value);
-			if(_p_teleinfoListener) {_p_teleinfoListener->hpIndexChanged(_hcIndex._fieldValue);}
-			LOG_DEBUG_LN("%s = %dWh", _hpIndex._as8_name, _hpIndex._fieldValue);
+			_frame._phases[loc_u8_phase]._u16_overInt = 0;
 		}
-		return NO_ERROR;
+		_changedMask = teleinfoFieldMask(ADIR_FIELD);
+		_b_shortFrame = false;
 	}
-	/** Base index - BASE */
-	else if(strcmp(_baseIndex._as8_name, arg_s8_label) == 0)
+}
+
+uint32_t Teleinfo::getFieldAge(ETeleinfoField arg_e_field) const
+{
+	return millis() - _au32_fieldUpdateMs[arg_e_field];
+}
+
+void Teleinfo::stopRead(void)
+{
+	_continueRead = false;
+}
+
+bool Teleinfo::registerListener(ITeleinfoListener& arg_listener, TeleinfoFieldMask arg_interestMask)
+{
+	if(_u8_nbListeners == MAX_LISTENERS)
 	{
-		if(arg_u8_valueLen != _baseIndex._u8_nbBytes)
-		{
-			return INVALID_LENGTH;
-		}
-		if(_baseIndex._fieldValue != (uint32_t)atoi((const char*) arg_u8_value))
-		{
-			_baseIndex._fieldValue = atoi((const char*) arg_u8_value);
-			if(_p_teleinfoListener) {_p_teleinfoListener->baseIndexChanged(_baseIndex._fieldValue);}
-			LOG_DEBUG_LN("%s = %dWh", _baseIndex._as8_name, _baseIndex._fieldValue);
-		}
-		return NO_ERROR;
+		ASSERT(false);
+		return false;
 	}
-	/** Message indicating EJP - PTEC */
-	else if(strcmp(_ejpMess._as8_name, arg_s8_label) == 0)
+
+	_listeners[_u8_nbListeners]._p_listener = &arg_listener;
+	_listeners[_u8_nbListeners]._interestMask = arg_interestMask;
+	_u8_nbListeners++;
+	return true;
+}
+
+void Teleinfo::unRegisterListener(ITeleinfoListener& arg_listener)
+{
+	for(uint8_t loc_u8_index = 0; loc_u8_index < _u8_nbListeners; loc_u8_index++)
 	{
-		if(arg_u8_valueLen != _ejpMess._u8_nbBytes)
+		if(_listeners[loc_u8_index]._p_listener == &arg_listener)
 		{
-			return INVALID_LENGTH;
-		}
-		if(_ejpMess._fieldValue == atoi((const char*) arg_u8_value))
-		{
-			_ejpMess._fieldValue = atoi((const char*) arg_u8_value);
-			if(_p_teleinfoListener) {_p_teleinfoListener->ejpMessChanged(_ejpMess._fieldValue);}
-			LOG_DEBUG_LN("%s = %dmin", _ejpMess._as8_name, _ejpMess._fieldValue);
+			/** keep registration order */
+			for(; loc_u8_index + 1 < _u8_nbListeners; loc_u8_index++)
+			{
+				_listeners[loc_u8_index] = _listeners[loc_u8_index + 1];
+			}
+			_u8_nbListeners--;
+			return;
 		}
-		return NO_ERROR;
 	}
-	/** Current pricing option - PTEC*/
-	else if(strcmp(_currTar._as8_name, arg_s8_label) == 0)
+}
+
+/*************************************
+ * Field decoders
+ *************************************/
+/**
+ * Convert a fixed width decimal value, not relying on null char. Digits are
+ * validated and converted 4 at a time in a 32 bits word (SWAR) - first digit
+ * in LSB on little endian targets
+ */
+static Teleinfo::EError decodeNumber(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded)
+{
+	/** 999999999 fits in 32 bits */
+	const uint8_t MAX_DIGITS = 9;
+	uint32_t loc_u32_value = 0;
+	uint32_t loc_u32_word = 0;
+	uint8_t loc_u8_index = 0;
+
+	if(arg_u8_valueLen == 0 || arg_u8_valueLen > MAX_DIGITS)
 	{
-		if(arg_u8_valueLen != _currTar._u8_nbBytes)
-		{
-			return INVALID_LENGTH;
-		}
+		return Teleinfo::INVALID_VALUE;
+	}
 
-		for(uint8_t loc_u8_tarIndex = 0; loc_u8_tarIndex < NB_PTEC; loc_u8_tarIndex++)
+	/** leading digits, remaining ones are then converted by words */
+	for(; loc_u8_index < (arg_u8_valueLen & 0x3); loc_u8_index++)
+	{
+		uint8_t loc_u8_digit = arg_au8_value[loc_u8_index] - '0';
+		if(loc_u8_digit > 9)
 		{
-			if(strcmp(PTEC[loc_u8_tarIndex]._teleinfoField, (const char*) arg_u8_value) == 0)
-			{
-			   if(_currTar._fieldValue != PTEC[loc_u8_tarIndex]._e_Val)
-			   {
-				   _currTar._fieldValue = PTEC[loc_u8_tarIndex]._e_Val;
-				   if(_p_teleinfoListener) {_p_teleinfoListener->currTarChanged(_currTar._fieldValue);}
-				   LOG_DEBUG_LN("%s = %d", _currTar._as8_name, _currTar._fieldValue);
-			   }
-				return NO_ERROR;
-			}
+			return Teleinfo::INVALID_VALUE;
 		}
-		return INVALID_VALUE;
+		loc_u32_value = loc_u32_value * 10 + loc_u8_digit;
 	}
-	/** Apparent power - PAPP */
-	else if(strcmp(_appPower._as8_name, arg_s8_label) == 0)
+
+	for(; loc_u8_index < arg_u8_valueLen; loc_u8_index += 4)
 	{
-		if(arg_u8_valueLen != _appPower._u8_nbBytes)
-		{
-			return INVALID_LENGTH;
-		}
-		if(_appPower._fieldValue != (uint32_t)atoi((const char*)arg_u8_value))
+		/** value may not be aligned */
+		memcpy(&loc_u32_word, &arg_au8_value[loc_u8_index], sizeof(loc_u32_word));
+
+		/** each byte in 0x30..0x39 : high nibble is 3, and adding 6 does not carry into it */
+		if((loc_u32_word & 0xF0F0F0F0) != 0x30303030
+				|| ((loc_u32_word + 0x06060606) & 0xF0F0F0F0) != 0x30303030)
 		{
-			_appPower._fieldValue = atoi((const char*)arg_u8_value);
-			if(_p_teleinfoListener) {_p_teleinfoListener->appPowerChanged(_appPower._fieldValue);}
-			LOG_DEBUG_LN("%s = %dVA", _appPower._as8_name, _appPower._fieldValue);
+			return Teleinfo::INVALID_VALUE;
 		}
-		return NO_ERROR;
+
+		loc_u32_word -= 0x30303030;
+		/** 2 digits numbers in bytes 0 and 2 */
+		loc_u32_word = (loc_u32_word * 10 + (loc_u32_word >> 8)) & 0x00FF00FF;
+		/** 4 digits number in low half word */
+		loc_u32_word = (loc_u32_word * 100 + (loc_u32_word >> 16)) & 0xFFFF;
+
+		loc_u32_value = loc_u32_value * 10000 + loc_u32_word;
 	}
-	/** HHPHC */
-	else if(strcmp(_hhphc._as8_name, arg_s8_label) == 0)
+
+	*arg_p_u32_decoded = loc_u32_value;
+	return Teleinfo::NO_ERROR;
+}
+
+/**
+ * Map a 4 chars value, compared as an integer
+ * @param arg_u32_value received value packed like ValueMapping values
+ */
+static Teleinfo::EError decodeMapping(const ValueMapping* arg_p_mappings, uint8_t arg_u8_nbMappings, uint32_t arg_u32_value, uint32_t* arg_p_u32_decoded)
+{
+	for(uint8_t loc_u8_index = 0; loc_u8_index < arg_u8_nbMappings; loc_u8_index++)
 	{
-		if(arg_u8_valueLen != _hhphc._u8_nbBytes)
-		{
-			return INVALID_LENGTH;
-		}
-		if(_hhphc._fieldValue != (char)arg_u8_value[0])
+		if(arg_p_mappings[loc_u8_index]._u32_value == arg_u32_value)
 		{
-			_hhphc._fieldValue = (char)arg_u8_value[0];
-			if(_p_teleinfoListener) {_p_teleinfoListener->hhphcChanged(_hhphc._fieldValue);}
-			LOG_DEBUG_LN("%s = %c", _hhphc._as8_name, _hhphc._fieldValue);
+			*arg_p_u32_decoded = arg_p_mappings[loc_u8_index]._u8_enum;
+			return Teleinfo::NO_ERROR;
 		}
-		return NO_ERROR;
-	}
-	else
-	{
-		LOG_ERROR("%s group not handled", arg_s8_label);
-		return NOT_HANDLED_GROUP;
 	}
+	return Teleinfo::INVALID_VALUE;
 }
 
-
-void Teleinfo::stopRead(void)
+/** @return 4 chars value packed, first char in LSB */
+static uint32_t packValue(const uint8_t* arg_au8_value)
 {
-	_continueRead = false;
+	uint32_t loc_u32_value = 0;
+	/** value may not be aligned */
+	memcpy(&loc_u32_value, arg_au8_value, sizeof(loc_u32_value));
+	return loc_u32_value;
 }
 
-void Teleinfo::registerListener(ITeleinfoListener& arg_listener)
+static Teleinfo::EError decodeOptTar(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded)
 {
-	/** only 1 listener */
-	if(_p_teleinfoListener != NULL)
-	{
-		ASSERT(false);
-	}
-	else
+	uint32_t loc_u32_value = packValue(arg_au8_value);
+
+	if((loc_u32_value & 0x00FFFFFF) == TEMPO_OPT_TAR_PREFIX)
 	{
-		 _p_teleinfoListener = &arg_listener;
+		*arg_p_u32_decoded = TEMPO_TAR;
+		return Teleinfo::NO_ERROR;
 	}
+	return decodeMapping(OPT_TAR, sizeof(OPT_TAR) / sizeof(OPT_TAR[0]), loc_u32_value, arg_p_u32_decoded);
 }
-void Teleinfo::unRegisterListener(ITeleinfoListener& arg_listener)
+
+static Teleinfo::EError decodePTEC(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded)
 {
-	_p_teleinfoListener = NULL;
+	return decodeMapping(PTEC, NB_PTEC, packValue(arg_au8_value), arg_p_u32_decoded);
 }
 
-Teleinfo::EError Teleinfo::readBytes(uint8_t arg_u8_readByte[], uint8_t arg_u8_nbBytes)
+static Teleinfo::EError decodeTempoColor(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded)
 {
-	unsigned long loc_u32_startMillis = millis();
-	const unsigned long READ_TIMEOUT_MS = 100;
-	const uint8_t READ_WAIT_MS = 10;
+	return decodeMapping(TEMPO_COLOR, NB_TEMPO_COLOR, packValue(arg_au8_value), arg_p_u32_decoded);
+}
 
-	uint8_t loc_u8_index = 0;
+static Teleinfo::EError decodeChar(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded)
+{
+	*arg_p_u32_decoded = arg_au8_value[0];
+	return Teleinfo::NO_ERROR;
+}
 
-	while(loc_u8_index < arg_u8_nbBytes)
+static Teleinfo::EError decodeHex(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded)
+{
+	uint32_t loc_u32_value = 0;
+
+	for(uint8_t loc_u8_index = 0; loc_u8_index < arg_u8_valueLen; loc_u8_index++)
 	{
-		if(_p_infoStream->available())
+		uint8_t loc_u8_char = arg_au8_value[loc_u8_index];
+		if(loc_u8_char >= '0' && loc_u8_char <= '9')
 		{
-			/** transmission on 7 bits - LSB*/
-			arg_u8_readByte[loc_u8_index++] = _p_infoStream->read() & 0x7F;
-			//LOG_INFO_LN("%x", arg_u8_readByte[loc_u8_index - 1]);
-			loc_u32_startMillis = millis();
+			loc_u32_value = (loc_u32_value << 4) | (loc_u8_char - '0');
 		}
-		else if(millis() - loc_u32_startMillis >= READ_TIMEOUT_MS)
+		else if(loc_u8_char >= 'A' && loc_u8_char <= 'F')
 		{
-			return READ_TIMEOUT;
+			loc_u32_value = (loc_u32_value << 4) | (loc_u8_char - 'A' + 10);
 		}
 		else
 		{
-			delay(READ_WAIT_MS);
+			return Teleinfo::INVALID_VALUE;
 		}
-
 	}
-	return NO_ERROR;
+	*arg_p_u32_decoded = loc_u32_value;
+	return Teleinfo::NO_ERROR;
 }
-
-bool Teleinfo::isCRCOK(char * arg_s8_label, uint8_t * arg_u8_value, uint8_t arg_u8_valueLen, uint8_t arg_u8_crc)
-{
-  uint8_t loc_u8_index = 0;
-
-  /** 1 space char to add - p11 - http://norm.edf.fr/pdf/HN44S812emeeditionMars2007.pdf */
-  uint8_t loc_u8_sum = SPACE;
-
-  while(arg_s8_label[loc_u8_index] != '\0')
-  {
-	  loc_u8_sum += arg_s8_label[loc_u8_index++];
-  }
-
-  for(loc_u8_index = 0; loc_u8_index < arg_u8_valueLen; )
-  {
-	  loc_u8_sum += arg_u8_value[loc_u8_index++];
-  }
-
-  loc_u8_sum = (loc_u8_sum & 0x3F) + 0x20;
-  return (loc_u8_sum == arg_u8_crc);
-}
-
-
@@ -25,6 +25,8 @@
 #include <stdint.h>
 #include <Stream.h>
 #include "teleinfo_listener.h"
+#include "teleinfo_frame.h"
+#include "teleinfo_stats.h"
 
 class Teleinfo{
 public:
@@ -38,23 +40,49 @@ public:
 		READ_TIMEOUT = -1,
 		NO_ERROR = 0,
 		FRAME_AVAILABLE = 1,
+		GROUP_AVAILABLE = 2,
 	}EError;
 
+	/** Teleinfo modes - refer Enedis-NOI-CPT_54E */
+	typedef enum{
+		TIC_MODE_UNKNOWN,
+		/** 1200 bauds, SPACE separator */
+		TIC_MODE_HISTORIC,
+		/** 9600 bauds, HTAB separator, optional timestamp */
+		TIC_MODE_STANDARD,
+	}ETicMode;
+
+	static const uint32_t HISTORIC_BAUDRATE = 1200;
+	static const uint32_t STANDARD_BAUDRATE = 9600;
+
+	/** gap between two frames counted as a read timeout */
+	static const uint32_t READ_TIMEOUT_MS = 5000;
+
+	/** max number of listeners registered at the same time */
+	static const uint8_t MAX_LISTENERS = 4;
+
 private:
 
-	/**
-	 * Teleinfo frame fied defined according to
-	 * http://norm.edf.fr/pdf/HN44S812emeeditionMars2007.pdf
-	 */
-	template <class T>
-	struct FrameField{
-		/** field name */
-		const char* _as8_name;
-		/** number of field data bytes */
-		const uint8_t _u8_nbBytes;
-		T _fieldValue;
+	/** Registered listener */
+	struct ListenerEntry{
+		ITeleinfoListener* _p_listener;
+		/** listener only notified when one of these fields changed */
+		TeleinfoFieldMask _interestMask;
 	};
 
+	/** Receive state machine states, kept between two fed bytes */
+	typedef enum{
+		/** waiting for STX */
+		WAIT_FRAME_START,
+		/** waiting for LF starting a group, or ETX ending frame */
+		WAIT_GROUP_START,
+		READ_LABEL,
+		/** read bytes after label separator up to CR */
+		READ_DATA,
+		/** group not handled in standard mode or invalid - wait LF or ETX */
+		SKIP_GROUP,
+	}EParserState;
+
 	/*****************************
 	 * Teleinfo special chars
 	 *****************************/
@@ -63,69 +91,158 @@ private:
 	static const uint8_t END_OF_TEXT       = 0x04;
 	static const uint8_t LINE_FEED         = 0x0A;
 	static const uint8_t SPACE             = 0x20;
+	static const uint8_t HTAB              = 0x09;
 	/** carriage return */
 	static const uint8_t CARRIAGE_RET      = 0x0D;
 	/** +1 for null char */
-	static const uint8_t LABEL_MAX_LENGTH  = 8 + 1;
-	static const uint8_t VALUE_MAX_LENGTH  = 15;
+	static const uint8_t LABEL_MAX_LENGTH  = 9 + 1;
+	/** [timestamp separator] value separator CRC */
+	static const uint8_t DATA_MAX_LENGTH   = 13 + 1 + 16 + 1 + 1;
 
 	/** Max teleinfo line length */
 	static const uint8_t MAX_LINE_LENGTH   = 21;
 
-	/*****************************
-	 * Teleinfo fields size
-	 *****************************/
-	static const uint8_t OP_TAR_LENGTH                  = 4;
-	static const uint8_t INDEX_LENGTH                   = 9;
-	static const uint8_t GAZ_INDEX_LENGTH               = 7;
-	static const uint8_t PTEC_LENGTH                    = 4;
-	static const uint8_t MOD_ETAT_LENGTH                = 6;
-	static const uint8_t CURR_INT_LENGTH                = 3;
-	static const uint8_t INT_LENGTH                     = 2;
-	static const uint8_t PTEC_MESS_LENGTH               = 2;
-	static const uint8_t POWER_LENGTH                   = 5;
-	static const uint8_t HHPHC_LENGTH                   = 1;
-
-	/*********************************************
-	 * teleinfo fields on client power meter side
-	 ********************************************/
-	struct FrameField<char*>     _telereportHubAddr     = {"ADCO",       TELEREPORT_HUB_ADDR_LENGTH,  NULL};
-	struct FrameField<EOptTar>   _optTar                = {"OPTARIF",    OP_TAR_LENGTH,               OPT_TAR_OUT_OF_ENUM};
-	struct FrameField<uint32_t>  _baseIndex             = {"BASE",       INDEX_LENGTH,                0};
-	struct FrameField<uint32_t>  _hcIndex               = {"HCHC",       INDEX_LENGTH,                0};
-	struct FrameField<uint32_t>  _hpIndex               = {"HCHP",       INDEX_LENGTH,                0};
-	struct FrameField<uint32_t>  _ejpHMIndex            = {"EJPHN",      INDEX_LENGTH,                0};
-	struct FrameField<uint32_t>  _ejpHPMIndex           = {"EJPHPM",     INDEX_LENGTH,                0};
-	struct FrameField<uint8_t>   _ejpMess               = {"PEJP",       PTEC_MESS_LENGTH,            0};
-	struct FrameField<uint32_t>  _gazIndex              = {"GAZ",        GAZ_INDEX_LENGTH,            0};
-	struct FrameField<EPTEC>     _currTar               = {"PTEC",       PTEC_LENGTH,                 PTEC_OUT_OF_ENUM};
-	struct FrameField<char*>     _modEtat               = {"MOTDETAT",   MOD_ETAT_LENGTH,             NULL};
-	struct FrameField<uint16_t>  _instInt               = {"IINST",      CURR_INT_LENGTH,             0};
-	struct FrameField<uint16_t>  _maxInt                = {"IMAX",       CURR_INT_LENGTH,             0};
-	struct FrameField<uint16_t>  _souscInt              = {"ISOUSC",     INT_LENGTH,                  0};
-	struct FrameField<uint32_t>  _appPower              = {"PAPP",       POWER_LENGTH,                0};
-	struct FrameField<char>      _hhphc                 = {"HHPHC",      HHPHC_LENGTH,                '0'};
-
-
-
-	/** telereport hub address field */
-	static const char* ADC0;
-	/** OPTAR mapping from teleinfo raw field to EOptTar*/
-	static const struct OPTarMapping OPT_TAR[NB_OPT_TAR];
-	/** PTEC mapping from teleinfo raw field to EPTEC*/
-	static const struct PTECMapping PTEC[NB_PTEC];
+	/** last values received */
+	TeleinfoFrame _frame;
 
 	/** teleinfo stream */
 	Stream* _p_infoStream;
 	bool _continueRead;
-	ITeleinfoListener* _p_teleinfoListener;
+	ListenerEntry _listeners[MAX_LISTENERS];
+	uint8_t _u8_nbListeners;
+
+	/** receive state machine context */
+	EParserState _e_state;
+	char _as8_label[LABEL_MAX_LENGTH];
+	uint8_t _u8_labelLength;
+	/** received label packed - refer TeleinfoLabels */
+	uint64_t _u64_labelKey;
+	/** SPACE or HTAB - gives group mode */
+	uint8_t _u8_separator;
+	/** field descriptor of group, resolved when label received */
+	uint8_t _u8_field;
+	uint8_t _au8_data[DATA_MAX_LENGTH];
+	uint8_t _u8_dataLength;
+	/** sum of group bytes received so far, checked against group CRC on CR */
+	uint8_t _u8_checksum;
+
+	/** mode of last valid group */
+	ETicMode _e_mode;
+	uint32_t _u32_nbValidGroups;
+
+	/** values changed in frames not notified yet - kept when a frame is dropped */
+	TeleinfoFieldMask _changedMask;
+	/** values received in current frame, changed or not */
+	TeleinfoFieldMask _receivedMask;
+	/** values received at least once */
+	TeleinfoFieldMask _seenMask;
+	/** end of last frame each value was received in - ms */
+	uint32_t _au32_fieldUpdateMs[NB_TELEINFO_FIELDS];
+	/** ADIRn received in current frame */
+	bool _b_shortFrame;
+	/** a group of current frame has been skipped on error */
+	bool _b_partialFrame;
+
+	/** health counters */
+	TeleinfoStats _stats;
+	/** time spent in endGroup() for current frame */
+	uint32_t _u32_frameParseUs;
+	/** last ETX time, valid if _b_frameEnded */
+	uint32_t _u32_frameEndMs;
+	bool _b_frameEnded;
 
 public:
 
+	/**
+	 * @param arg_p_stream stream teleinfo is read from. Can be NULL when
+	 * bytes are only given through feed()
+	 */
 	Teleinfo(Stream* arg_p_stream);
 
 	/**
-	 * Start teleinfo reading on Stream
+	 * Give one received byte to teleinfo parser. Parser state is kept between
+	 * calls so it can be called from an interrupt handler or a periodic task.
+	 * @param arg_u8_byte received byte
+	 * @return GROUP_AVAILABLE when a valid group has been parsed,
+	 * FRAME_AVAILABLE when end of frame has been received and listener
+	 * notified, NO_ERROR when more
+	 * bytes are needed, NOT_HANDLED_GROUP when a valid group is ignored, an
+	 * error < NO_ERROR otherwise - current group is then skipped up to next
+	 * LF, valid groups of frame are kept and frame is notified as partial
+	 */
+	EError feed(uint8_t arg_u8_byte);
+
+	/**
+	 * Give several received bytes to teleinfo parser
+	 * @param arg_au8_bytes received bytes
+	 * @param arg_u32_nbBytes number of bytes
+	 * @return FRAME_AVAILABLE if at least one frame ended in given bytes,
+	 * otherwise last error or NO_ERROR
+	 */
+	EError feed(const uint8_t* arg_au8_bytes, size_t arg_u32_nbBytes);
+
+	/**
+	 * Resolve a packed label the way received groups are dispatched
+	 * @param arg_u64_labelKey label packed with TeleinfoLabels::pack()
+	 * @param arg_e_mode TIC_MODE_STANDARD for standard labels, historic
+	 * labels otherwise
+	 * @return label field, NB_TELEINFO_FIELDS if label not handled
+	 */
+	static ETeleinfoField lookupLabel(uint64_t arg_u64_labelKey, ETicMode arg_e_mode);
+
+	/**
+	 * Convert a fixed width decimal value the way numeric groups are decoded
+	 * @param arg_au8_value value, null char not needed
+	 * @param arg_u8_valueLen number of digits - 9 max
+	 * @param arg_p_u32_decoded converted value
+	 * @return NO_ERROR or INVALID_VALUE
+	 */
+	static EError decodeDecimal(const uint8_t* arg_au8_value, uint8_t arg_u8_valueLen, uint32_t* arg_p_u32_decoded);
+
+	/**
+	 * Drop current frame, parser waits for next STX
+	 */
+	void resetParser(void);
+
+	/**
+	 * @return mode detected from last valid group separator
+	 */
+	ETicMode getMode(void) const {return _e_mode;};
+
+	/**
+	 * @return number of groups received with a valid CRC, used to detect
+	 * stream baudrate
+	 */
+	uint32_t getNbValidGroups(void) const {return _u32_nbValidGroups;};
+
+	/**
+	 * @return fields received at least once since start
+	 */
+	TeleinfoFieldMask getSeenFields(void) const {return _seenMask;};
+
+	/**
+	 * @return time since given field was last received - ms, meaningless
+	 * if not in getSeenFields()
+	 */
+	uint32_t getFieldAge(ETeleinfoField arg_e_field) const;
+
+	/**
+	 * @return parser health counters since start or last resetStats()
+	 */
+	const TeleinfoStats& getStats(void) const {return _stats;};
+
+	/**
+	 * Reset parser health counters
+	 */
+	void resetStats(void);
+
+	/**
+	 * @return last values received
+	 */
+	const TeleinfoFrame& getFrame(void) const {return _frame;};
+
+	/**
+	 * Start teleinfo reading on Stream. Blocking until stopRead() called
 	 */
 	void startRead(void);
 
@@ -136,58 +253,50 @@ public:
 
 	virtual ~Teleinfo();
 
-	void registerListener(ITeleinfoListener& arg_listener);
+	/**
+	 * Register a listener notified on frames changing given fields. Listeners
+	 * are notified in registration order
+	 * @param arg_listener
+	 * @param arg_interestMask fields listener is interested in
+	 * @return false if MAX_LISTENERS already registered
+	 */
+	bool registerListener(ITeleinfoListener& arg_listener, TeleinfoFieldMask arg_interestMask = ALL_TELEINFO_FIELDS);
 	void unRegisterListener(ITeleinfoListener& arg_listener);
 
 private:
 	/**
-	 * Parse given group and updates related teleinfo values
-	 * @param arg_s8_label
+	 * Parse given group and updates related teleinfo values according to
+	 * field descriptor
+	 * @param arg_u8_field received group field descriptor in historic or
+	 * standard table depending on group separator
 	 * @param arg_u8_value
 	 * @param arg_u8_valueLen
 	 * @return
 	 */
-	EError parseGroup(char * arg_s8_label, uint8_t * arg_u8_value, uint8_t arg_u8_valueLen);
-
-	/**
-	 * Read a given number of bytes
-	 * @param arg_u8_readByte
-	 * @param arg_u8_nbBytes
-	 * @return
-	 */
-	EError readBytes(uint8_t arg_u8_readByte[], uint8_t arg_u8_nbBytes);
-
-	/**
-	 * Read info groups in a frame
-	 * @return
-	 */
-	EError readInfoGroups(void);
+	EError parseGroup(uint8_t arg_u8_field, uint8_t * arg_u8_value, uint8_t arg_u8_valueLen);
 
 	/**
-	 * Read an info group
-	 * @return
+	 * Skip current group up to next LF or ETX and mark frame as partial
+	 * @param arg_e_error group error
+	 * @return arg_e_error
 	 */
-	EError readInfoGroup(void);
+	EError skipGroup(EError arg_e_error);
 
 	/**
-	 * @param label read
-	 * @return
+	 * Count group error in stats
 	 */
-	EError readGroupLabel(char arg_as8_label[LABEL_MAX_LENGTH]);
+	void countError(EError arg_e_error);
 
 	/**
-	 *
-	 * @param arg_au8_value
-	 * @param arg_u8_value_length
-	 * @return
+	 * Notify listener with frame values once ETX received
 	 */
-	EError readGroupValue(uint8_t arg_au8_value[VALUE_MAX_LENGTH], uint8_t* arg_u8_value_length);
+	void notifyFrame(void);
 
 	/**
-	 * Check Info Group CRC on a valid group label and value
+	 * Check CRC of received group and parse it
 	 * @return
 	 */
-	static bool isCRCOK(char * arg_s8_label, uint8_t * arg_u8_value, uint8_t arg_u8_valueLen, uint8_t arg_u8_crc);
+	EError endGroup(void);
 };
 
 #endif /* TELEINFO_TELEINFO_H_ */
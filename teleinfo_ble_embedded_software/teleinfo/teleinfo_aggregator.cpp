@@ -0,0 +1,251 @@
+/******************************************************************************
+ * @file    teleinfo_aggregator.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo values aggregation over fixed windows
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_aggregator.h"
+#include <delay.h>
+#include <stddef.h>
+#include <logger.h>
+
+/*************************************
+ * Static definitions
+ *************************************/
+#define INDEX_OFFSET(member) ((uint16_t) offsetof(TeleinfoFrame, member))
+
+/** EEnergyIndex storage in TeleinfoFrame */
+static const uint16_t ENERGY_INDEX_OFFSETS[NB_ENERGY_INDEXES] =
+{
+	INDEX_OFFSET(_u32_baseIndex),
+	INDEX_OFFSET(_u32_hcIndex),
+	INDEX_OFFSET(_u32_hpIndex),
+	INDEX_OFFSET(_u32_ejpHNIndex),
+	INDEX_OFFSET(_u32_ejpHPMIndex),
+	INDEX_OFFSET(_u32_bbrHCJBIndex),
+	INDEX_OFFSET(_u32_bbrHPJBIndex),
+	INDEX_OFFSET(_u32_bbrHCJWIndex),
+	INDEX_OFFSET(_u32_bbrHPJWIndex),
+	INDEX_OFFSET(_u32_bbrHCJRIndex),
+	INDEX_OFFSET(_u32_bbrHPJRIndex),
+};
+
+const TeleinfoFieldMask TeleinfoAggregator::AGGREGATED_FIELDS = teleinfoFieldMask(PAPP_FIELD) | teleinfoFieldMask(IINST_FIELD)
+		| teleinfoFieldMask(PHASE_IINST_FIELD) | teleinfoFieldMask(BASE_FIELD) | teleinfoFieldMask(HCHC_FIELD)
+		| teleinfoFieldMask(HCHP_FIELD) | teleinfoFieldMask(EJPHN_FIELD) | teleinfoFieldMask(EJPHPM_FIELD)
+		| teleinfoFieldMask(BBRHCJB_FIELD) | teleinfoFieldMask(BBRHPJB_FIELD) | teleinfoFieldMask(BBRHCJW_FIELD)
+		| teleinfoFieldMask(BBRHPJW_FIELD) | teleinfoFieldMask(BBRHCJR_FIELD) | teleinfoFieldMask(BBRHPJR_FIELD);
+
+/*************************************
+ * Public functions
+ *************************************/
+uint32_t teleinfoEnergyIndex(const TeleinfoFrame& arg_frame, uint8_t arg_u8_index)
+{
+	return *(const uint32_t*)(((const uint8_t*) &arg_frame) + ENERGY_INDEX_OFFSETS[arg_u8_index]);
+}
+
+/*************************************
+ * Private functions
+ *************************************/
+
+/** @return IINST on single phase meters, max of IINSTn on three-phase meters */
+static uint32_t instInt(const TeleinfoFrame& arg_frame)
+{
+	uint32_t loc_u32_max = arg_frame._u16_instInt;
+
+	for(uint8_t loc_u8_phase = 0; loc_u8_phase < TeleinfoFrame::NB_PHASES; loc_u8_phase++)
+	{
+		if(arg_frame._phases[loc_u8_phase]._u16_instInt > loc_u32_max)
+		{
+			loc_u32_max = arg_frame._phases[loc_u8_phase]._u16_instInt;
+		}
+	}
+	return loc_u32_max;
+}
+
+/*************************************
+ * Method definitions
+ *************************************/
+TeleinfoAggregator::TeleinfoAggregator(ITeleinfoAggregateListener& arg_listener, const uint32_t arg_au32_windowsS[], uint8_t arg_u8_nbWindows) :
+	_p_listener(&arg_listener),
+	_u8_nbWindows(arg_u8_nbWindows),
+	_p_frame(NULL)
+{
+	if(_u8_nbWindows > MAX_WINDOWS)
+	{
+		ASSERT(false);
+		_u8_nbWindows = MAX_WINDOWS;
+	}
+
+	for(uint8_t loc_u8_window = 0; loc_u8_window < _u8_nbWindows; loc_u8_window++)
+	{
+		ASSERT(arg_au32_windowsS[loc_u8_window] > 0 && arg_au32_windowsS[loc_u8_window] <= MAX_WINDOW_DURATION_S);
+		_windows[loc_u8_window]._u32_durationS = arg_au32_windowsS[loc_u8_window];
+	}
+}
+
+void TeleinfoAggregator::poll(void)
+{
+	if(_p_frame != NULL)
+	{
+		endElapsedWindows(millis());
+	}
+}
+
+bool TeleinfoAggregator::setWindowDuration(uint8_t arg_u8_window, uint32_t arg_u32_durationS)
+{
+	if(arg_u8_window >= _u8_nbWindows || arg_u32_durationS == 0 || arg_u32_durationS > MAX_WINDOW_DURATION_S)
+	{
+		return false;
+	}
+
+	_windows[arg_u8_window]._u32_durationS = arg_u32_durationS;
+	/** otherwise started on first frame */
+	if(_p_frame != NULL)
+	{
+		startWindow(_windows[arg_u8_window], millis());
+	}
+	return true;
+}
+
+void TeleinfoAggregator::onFrame(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask)
+{
+	uint32_t loc_u32_nowMs = millis();
+
+	/** windows start with first frame */
+	if(_p_frame == NULL)
+	{
+		_p_frame = &arg_frame;
+		for(uint8_t loc_u8_window = 0; loc_u8_window < _u8_nbWindows; loc_u8_window++)
+		{
+			startWindow(_windows[loc_u8_window], loc_u32_nowMs);
+		}
+		return;
+	}
+
+	/** windows elapsed before this frame end with previous values */
+	endElapsedWindows(loc_u32_nowMs);
+
+	for(uint8_t loc_u8_window = 0; loc_u8_window < _u8_nbWindows; loc_u8_window++)
+	{
+		Window& loc_window = _windows[loc_u8_window];
+
+		setValue(loc_window._appPower, arg_frame._u32_appPower, loc_u32_nowMs);
+		setValue(loc_window._instInt, instInt(arg_frame), loc_u32_nowMs);
+
+		/** index received for the first time */
+		for(uint8_t loc_u8_index = 0; loc_u8_index < NB_ENERGY_INDEXES; loc_u8_index++)
+		{
+			if(loc_window._au32_startIndexes[loc_u8_index] == 0)
+			{
+				loc_window._au32_startIndexes[loc_u8_index] = teleinfoEnergyIndex(arg_frame, loc_u8_index);
+			}
+		}
+	}
+}
+
+void TeleinfoAggregator::startWindow(Window& arg_window, uint32_t arg_u32_nowMs)
+{
+	uint32_t loc_u32_appPower = _p_frame->_u32_appPower;
+	uint32_t loc_u32_instInt = instInt(*_p_frame);
+
+	arg_window._u32_startMs = arg_u32_nowMs;
+
+	arg_window._appPower._u32_min = loc_u32_appPower;
+	arg_window._appPower._u32_max = loc_u32_appPower;
+	arg_window._appPower._u32_value = loc_u32_appPower;
+	arg_window._appPower._u64_integral = 0;
+	arg_window._appPower._u32_lastMs = arg_u32_nowMs;
+
+	arg_window._instInt._u32_min = loc_u32_instInt;
+	arg_window._instInt._u32_max = loc_u32_instInt;
+	arg_window._instInt._u32_value = loc_u32_instInt;
+	arg_window._instInt._u64_integral = 0;
+	arg_window._instInt._u32_lastMs = arg_u32_nowMs;
+
+	for(uint8_t loc_u8_index = 0; loc_u8_index < NB_ENERGY_INDEXES; loc_u8_index++)
+	{
+		arg_window._au32_startIndexes[loc_u8_index] = teleinfoEnergyIndex(*_p_frame, loc_u8_index);
+	}
+}
+
+void TeleinfoAggregator::endWindow(uint8_t arg_u8_window, uint32_t arg_u32_nowMs)
+{
+	Window& loc_window = _windows[arg_u8_window];
+	TeleinfoAggregate loc_aggregate;
+	uint32_t loc_u32_durationMs = arg_u32_nowMs - loc_window._u32_startMs;
+
+	accumulate(loc_window._appPower, arg_u32_nowMs);
+	accumulate(loc_window._instInt, arg_u32_nowMs);
+
+	loc_aggregate._u8_window = arg_u8_window;
+	loc_aggregate._u32_durationS = loc_u32_durationMs / 1000;
+
+	loc_aggregate._appPower._u32_min = loc_window._appPower._u32_min;
+	loc_aggregate._appPower._u32_max = loc_window._appPower._u32_max;
+	loc_aggregate._appPower._u32_mean = loc_u32_durationMs ? (uint32_t)(loc_window._appPower._u64_integral / loc_u32_durationMs) : loc_window._appPower._u32_value;
+
+	loc_aggregate._instInt._u32_min = loc_window._instInt._u32_min;
+	loc_aggregate._instInt._u32_max = loc_window._instInt._u32_max;
+	loc_aggregate._instInt._u32_mean = loc_u32_durationMs ? (uint32_t)(loc_window._instInt._u64_integral / loc_u32_durationMs) : loc_window._instInt._u32_value;
+
+	for(uint8_t loc_u8_index = 0; loc_u8_index < NB_ENERGY_INDEXES; loc_u8_index++)
+	{
+		uint32_t loc_u32_start = loc_window._au32_startIndexes[loc_u8_index];
+		uint32_t loc_u32_end = teleinfoEnergyIndex(*_p_frame, loc_u8_index);
+		uint32_t loc_u32_delta = (loc_u32_start != 0 && loc_u32_end >= loc_u32_start) ? loc_u32_end - loc_u32_start : 0;
+
+		loc_aggregate._au16_energyWh[loc_u8_index] = (loc_u32_delta > 0xFFFF) ? 0xFFFF : (uint16_t) loc_u32_delta;
+	}
+	loc_aggregate._b_totalIndex = teleinfoEnergyIndex(*_p_frame, BASE_INDEX) != 0;
+
+	_p_listener->onAggregate(loc_aggregate);
+	startWindow(loc_window, arg_u32_nowMs);
+}
+
+void TeleinfoAggregator::endElapsedWindows(uint32_t arg_u32_nowMs)
+{
+	for(uint8_t loc_u8_window = 0; loc_u8_window < _u8_nbWindows; loc_u8_window++)
+	{
+		/** compared in s : no overflow whatever duration */
+		if((arg_u32_nowMs - _windows[loc_u8_window]._u32_startMs) / 1000 >= _windows[loc_u8_window]._u32_durationS)
+		{
+			endWindow(loc_u8_window, arg_u32_nowMs);
+		}
+	}
+}
+
+void TeleinfoAggregator::accumulate(ValueAccumulator& arg_acc, uint32_t arg_u32_nowMs)
+{
+	arg_acc._u64_integral += (uint64_t) arg_acc._u32_value * (arg_u32_nowMs - arg_acc._u32_lastMs);
+	arg_acc._u32_lastMs = arg_u32_nowMs;
+}
+
+void TeleinfoAggregator::setValue(ValueAccumulator& arg_acc, uint32_t arg_u32_value, uint32_t arg_u32_nowMs)
+{
+	accumulate(arg_acc, arg_u32_nowMs);
+	arg_acc._u32_value = arg_u32_value;
+	if(arg_u32_value < arg_acc._u32_min)
+	{
+		arg_acc._u32_min = arg_u32_value;
+	}
+	if(arg_u32_value > arg_acc._u32_max)
+	{
+		arg_acc._u32_max = arg_u32_value;
+	}
+}
@@ -0,0 +1,174 @@
+/******************************************************************************
+ * @file    teleinfo_aggregator.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo listener aggregating PAPP, IINST and consumed energy over
+ * fixed windows, so that a summary survives a lost change notification
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_TELEINFO_AGGREGATOR_H_
+#define TELEINFO_TELEINFO_AGGREGATOR_H_
+
+#include <stdint.h>
+#include "teleinfo_listener.h"
+
+/** energy indexes aggregated */
+typedef enum{
+	BASE_INDEX = 0,
+	HC_INDEX,
+	HP_INDEX,
+	EJP_HN_INDEX,
+	EJP_HPM_INDEX,
+	BBR_HCJB_INDEX,
+	BBR_HPJB_INDEX,
+	BBR_HCJW_INDEX,
+	BBR_HPJW_INDEX,
+	BBR_HCJR_INDEX,
+	BBR_HPJR_INDEX,
+	NB_ENERGY_INDEXES
+}EEnergyIndex;
+
+/**
+ * @param arg_u8_index EEnergyIndex
+ * @return energy index value in frame - Wh, 0 if not received
+ */
+uint32_t teleinfoEnergyIndex(const TeleinfoFrame& arg_frame, uint8_t arg_u8_index);
+
+/** min / time weighted mean / max of a value over a window */
+struct TeleinfoAggregateValue{
+	uint32_t _u32_min;
+	uint32_t _u32_mean;
+	uint32_t _u32_max;
+};
+
+/** summary of a window */
+struct TeleinfoAggregate{
+	/** window index in aggregator windows */
+	uint8_t _u8_window;
+	uint32_t _u32_durationS;
+	/** PAPP - VA */
+	TeleinfoAggregateValue _appPower;
+	/** IINST or max of IINSTn - A */
+	TeleinfoAggregateValue _instInt;
+	/** energy consumed on each index during window - Wh, saturated */
+	uint16_t _au16_energyWh[NB_ENERGY_INDEXES];
+	/**
+	 * BASE index received : it holds total energy. In standard mode, EAST is
+	 * stored in BASE and EASF01/02 tariff indexes in HC/HP
+	 */
+	bool _b_totalIndex;
+
+	/** @return energy consumed on all indexes - Wh */
+	uint32_t totalEnergyWh(void) const
+	{
+		uint32_t loc_u32_total = 0;
+		if(_b_totalIndex)
+		{
+			return _au16_energyWh[BASE_INDEX];
+		}
+		for(uint8_t loc_u8_index = 0; loc_u8_index < NB_ENERGY_INDEXES; loc_u8_index++)
+		{
+			loc_u32_total += _au16_energyWh[loc_u8_index];
+		}
+		return loc_u32_total;
+	};
+};
+
+class ITeleinfoAggregateListener {
+	public :
+	virtual ~ITeleinfoAggregateListener(void){};
+
+	/**
+	 * Called when a window ends
+	 * @param arg_aggregate window summary
+	 */
+	virtual void onAggregate(const TeleinfoAggregate& arg_aggregate) = 0;
+};
+
+class TeleinfoAggregator : public ITeleinfoListener {
+public:
+	static const uint8_t MAX_WINDOWS = 3;
+	/** one day - keeps window duration in ms and energy deltas in range */
+	static const uint32_t MAX_WINDOW_DURATION_S = 86400;
+
+	/** fields aggregator must be registered for */
+	static const TeleinfoFieldMask AGGREGATED_FIELDS;
+
+private:
+	/** time weighted accumulation of a value held between two notifications */
+	struct ValueAccumulator{
+		uint32_t _u32_min;
+		uint32_t _u32_max;
+		/** value x ms */
+		uint64_t _u64_integral;
+		uint32_t _u32_value;
+		uint32_t _u32_lastMs;
+	};
+
+	struct Window{
+		uint32_t _u32_durationS;
+		uint32_t _u32_startMs;
+		ValueAccumulator _appPower;
+		ValueAccumulator _instInt;
+		/** indexes at window start, 0 if unknown */
+		uint32_t _au32_startIndexes[NB_ENERGY_INDEXES];
+	};
+
+	ITeleinfoAggregateListener* _p_listener;
+	Window _windows[MAX_WINDOWS];
+	uint8_t _u8_nbWindows;
+	/** last frame notified by teleinfo, NULL before first frame */
+	const TeleinfoFrame* _p_frame;
+
+public:
+	/**
+	 * @param arg_listener notified of windows summaries
+	 * @param arg_au32_windowsS windows durations - s, at most
+	 * MAX_WINDOW_DURATION_S
+	 * @param arg_u8_nbWindows at most MAX_WINDOWS
+	 */
+	TeleinfoAggregator(ITeleinfoAggregateListener& arg_listener, const uint32_t arg_au32_windowsS[], uint8_t arg_u8_nbWindows);
+	virtual ~TeleinfoAggregator(void){};
+
+	/**
+	 * End elapsed windows even if no frame received. Must be called
+	 * periodically
+	 */
+	void poll(void);
+
+	/**
+	 * Change a window duration, window restarted
+	 * @param arg_u8_window index given to constructor
+	 * @param arg_u32_durationS
+	 * @return false if window does not exist, duration is 0 or greater than
+	 * MAX_WINDOW_DURATION_S
+	 */
+	bool setWindowDuration(uint8_t arg_u8_window, uint32_t arg_u32_durationS);
+
+	/** from ITeleinfoListener */
+	void onFrame(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask);
+
+private:
+	void startWindow(Window& arg_window, uint32_t arg_u32_nowMs);
+	void endWindow(uint8_t arg_u8_window, uint32_t arg_u32_nowMs);
+	void endElapsedWindows(uint32_t arg_u32_nowMs);
+
+	static void accumulate(ValueAccumulator& arg_acc, uint32_t arg_u32_nowMs);
+	static void setValue(ValueAccumulator& arg_acc, uint32_t arg_u32_value, uint32_t arg_u32_nowMs);
+};
+
+#endif /* TELEINFO_TELEINFO_AGGREGATOR_H_ */
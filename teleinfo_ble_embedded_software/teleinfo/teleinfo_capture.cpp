@@ -0,0 +1,257 @@
+/******************************************************************************
+ * @file    teleinfo_capture.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Record and replay raw teleinfo byte streams
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_capture.h"
+#include <delay.h>
+#include <string.h>
+
+/*************************************
+ * Private functions
+ *************************************/
+static const uint8_t CAPTURE_MAGIC[4] = {'T', 'I', 'C', 'C'};
+
+static void writeU32(uint8_t* arg_au8_dest, uint32_t arg_u32_value)
+{
+	arg_au8_dest[0] = (uint8_t) arg_u32_value;
+	arg_au8_dest[1] = (uint8_t)(arg_u32_value >> 8);
+	arg_au8_dest[2] = (uint8_t)(arg_u32_value >> 16);
+	arg_au8_dest[3] = (uint8_t)(arg_u32_value >> 24);
+}
+
+static uint32_t readU32(const uint8_t* arg_au8_src)
+{
+	return (uint32_t) arg_au8_src[0] | ((uint32_t) arg_au8_src[1] << 8)
+			| ((uint32_t) arg_au8_src[2] << 16) | ((uint32_t) arg_au8_src[3] << 24);
+}
+
+/*************************************
+ * TeleinfoCaptureRecorder
+ *************************************/
+TeleinfoCaptureRecorder::TeleinfoCaptureRecorder(Stream& arg_stream, uint8_t* arg_au8_capture, size_t arg_u32_captureSize, uint32_t arg_u32_baudrate) :
+	_p_stream(&arg_stream),
+	_au8_capture(arg_au8_capture),
+	_u32_captureSize(arg_u32_captureSize),
+	_u32_captureLength(0),
+	_u64_lastByteUs(micros64())
+{
+	if(_u32_captureSize >= TeleinfoCapture::HEADER_LENGTH)
+	{
+		memcpy(_au8_capture, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+		_au8_capture[4] = TeleinfoCapture::VERSION;
+		writeU32(&_au8_capture[5], arg_u32_baudrate);
+		_u32_captureLength = TeleinfoCapture::HEADER_LENGTH;
+	}
+}
+
+int TeleinfoCaptureRecorder::available(void)
+{
+	return _p_stream->available();
+}
+
+int TeleinfoCaptureRecorder::read(void)
+{
+	int loc_s32_byte = _p_stream->read();
+	uint64_t loc_u64_nowUs = micros64();
+	uint64_t loc_u64_delayUs = loc_u64_nowUs - _u64_lastByteUs;
+
+	if(loc_s32_byte >= 0 && _u32_captureLength >= TeleinfoCapture::HEADER_LENGTH && !isFull())
+	{
+		writeU32(&_au8_capture[_u32_captureLength], loc_u64_delayUs > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) loc_u64_delayUs);
+		_au8_capture[_u32_captureLength + 4] = (uint8_t) loc_s32_byte;
+		_u32_captureLength += TeleinfoCapture::RECORD_LENGTH;
+		_u64_lastByteUs = loc_u64_nowUs;
+	}
+	return loc_s32_byte;
+}
+
+int TeleinfoCaptureRecorder::peek(void)
+{
+	return _p_stream->peek();
+}
+
+void TeleinfoCaptureRecorder::flush(void)
+{
+	_p_stream->flush();
+}
+
+size_t TeleinfoCaptureRecorder::write(uint8_t arg_u8_byte)
+{
+	return _p_stream->write(arg_u8_byte);
+}
+
+/*************************************
+ * TeleinfoCaptureStream
+ *************************************/
+TeleinfoCaptureStream::TeleinfoCaptureStream(const uint8_t* arg_au8_capture, size_t arg_u32_captureLength) :
+	_au8_capture(arg_au8_capture),
+	_u32_captureLength(arg_u32_captureLength),
+	_u32_offset(TeleinfoCapture::HEADER_LENGTH),
+	_e_speed(REPLAY_UNTHROTTLED),
+	_u16_speedFactor(1),
+	_u64_startUs(0),
+	_u64_nextByteUs(0)
+{
+	if(!isValid())
+	{
+		/** nothing to replay */
+		_u32_captureLength = 0;
+	}
+}
+
+bool TeleinfoCaptureStream::isValid(void) const
+{
+	return _u32_captureLength >= TeleinfoCapture::HEADER_LENGTH
+			&& memcmp(_au8_capture, CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC)) == 0
+			&& _au8_capture[4] == TeleinfoCapture::VERSION;
+}
+
+uint32_t TeleinfoCaptureStream::getBaudrate(void) const
+{
+	return isValid() ? readU32(&_au8_capture[5]) : 0;
+}
+
+void TeleinfoCaptureStream::start(EReplaySpeed arg_e_speed, uint16_t arg_u16_speedFactor)
+{
+	_e_speed = arg_e_speed;
+	_u16_speedFactor = (arg_e_speed == REPLAY_ACCELERATED && arg_u16_speedFactor > 0) ? arg_u16_speedFactor : 1;
+	_u32_offset = TeleinfoCapture::HEADER_LENGTH;
+	_u64_nextByteUs = isFinished() ? 0 : recordDelay(_u32_offset);
+	_u64_startUs = micros64();
+}
+
+int TeleinfoCaptureStream::available(void)
+{
+	if(isFinished())
+	{
+		return 0;
+	}
+	if(_e_speed == REPLAY_UNTHROTTLED)
+	{
+		return 1;
+	}
+	/** next byte received yet? */
+	return (micros64() - _u64_startUs) * _u16_speedFactor >= _u64_nextByteUs ? 1 : 0;
+}
+
+int TeleinfoCaptureStream::read(void)
+{
+	uint8_t loc_u8_byte = 0;
+
+	if(!available())
+	{
+		return -1;
+	}
+
+	loc_u8_byte = _au8_capture[_u32_offset + 4];
+	_u32_offset += TeleinfoCapture::RECORD_LENGTH;
+	if(!isFinished())
+	{
+		_u64_nextByteUs += recordDelay(_u32_offset);
+	}
+	return loc_u8_byte;
+}
+
+int TeleinfoCaptureStream::peek(void)
+{
+	return available() ? _au8_capture[_u32_offset + 4] : -1;
+}
+
+void TeleinfoCaptureStream::flush(void)
+{
+}
+
+size_t TeleinfoCaptureStream::write(uint8_t arg_u8_byte)
+{
+	/** teleinfo is a receive only link */
+	return 0;
+}
+
+uint32_t TeleinfoCaptureStream::recordDelay(size_t arg_u32_offset) const
+{
+	return readU32(&_au8_capture[arg_u32_offset]);
+}
+
+/*************************************
+ * Replay
+ *************************************/
+void replayTeleinfoCapture(Teleinfo& arg_teleinfo, TeleinfoCaptureStream& arg_stream, TeleinfoReplayReport& arg_report)
+{
+	Teleinfo::EError loc_e_error = Teleinfo::NO_ERROR;
+	uint32_t loc_u32_replayStartUs = micros();
+	uint32_t loc_u32_feedStartUs = 0;
+	uint32_t loc_u32_frameParseUs = 0;
+
+	memset(&arg_report, 0, sizeof(arg_report));
+	arg_report._u32_minFrameParseUs = 0xFFFFFFFF;
+	arg_teleinfo.resetParser();
+
+	while(!arg_stream.isFinished())
+	{
+		if(!arg_stream.available())
+		{
+			continue;
+		}
+
+		uint8_t loc_u8_byte = (uint8_t) arg_stream.read();
+		loc_u32_feedStartUs = micros();
+		loc_e_error = arg_teleinfo.feed(loc_u8_byte);
+		loc_u32_frameParseUs += micros() - loc_u32_feedStartUs;
+		arg_report._u32_nbBytes++;
+
+		switch(loc_e_error)
+		{
+		case Teleinfo::FRAME_AVAILABLE :
+			arg_report._u32_nbFrames++;
+			arg_report._u32_totalParseUs += loc_u32_frameParseUs;
+			if(loc_u32_frameParseUs < arg_report._u32_minFrameParseUs)
+			{
+				arg_report._u32_minFrameParseUs = loc_u32_frameParseUs;
+			}
+			if(loc_u32_frameParseUs > arg_report._u32_maxFrameParseUs)
+			{
+				arg_report._u32_maxFrameParseUs = loc_u32_frameParseUs;
+			}
+			loc_u32_frameParseUs = 0;
+			break;
+		case Teleinfo::GROUP_AVAILABLE :
+			arg_report._u32_nbGroups++;
+			break;
+		case Teleinfo::NOT_HANDLED_GROUP :
+			arg_report._u32_nbIgnoredGroups++;
+			break;
+		case Teleinfo::INVALID_CRC :
+			arg_report._u32_nbCRCErrors++;
+			break;
+		default :
+			if(loc_e_error < Teleinfo::NO_ERROR)
+			{
+				arg_report._u32_nbErrors++;
+			}
+			break;
+		}
+	}
+
+	arg_report._u32_elapsedUs = micros() - loc_u32_replayStartUs;
+	if(arg_report._u32_nbFrames == 0)
+	{
+		arg_report._u32_minFrameParseUs = 0;
+	}
+}
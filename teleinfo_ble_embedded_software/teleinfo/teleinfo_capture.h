@@ -0,0 +1,181 @@
+/******************************************************************************
+ * @file    teleinfo_capture.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Record and replay raw teleinfo byte streams, in order to reproduce
+ * field issues and measure parser throughput off device.
+ *
+ * Capture format, all values little endian :
+ *  - header : "TICC" magic, 1 byte version, 4 bytes baudrate
+ *  - records : 4 bytes delay in us since previous byte, 1 byte received byte.
+ *  Delay saturates at 0xFFFFFFFF - 71 min
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_TELEINFO_CAPTURE_H_
+#define TELEINFO_TELEINFO_CAPTURE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <Stream.h>
+#include "teleinfo.h"
+
+namespace TeleinfoCapture
+{
+	static const uint8_t VERSION          = 1;
+	/** magic, version, baudrate */
+	static const uint8_t HEADER_LENGTH    = 4 + 1 + 4;
+	/** delay since previous byte, byte */
+	static const uint8_t RECORD_LENGTH    = 4 + 1;
+}
+
+/**
+ * Stream wrapper recording bytes read from teleinfo stream with their arrival
+ * time in a capture buffer
+ */
+class TeleinfoCaptureRecorder : public Stream {
+private:
+	Stream* _p_stream;
+	uint8_t* _au8_capture;
+	size_t _u32_captureSize;
+	size_t _u32_captureLength;
+	uint64_t _u64_lastByteUs;
+
+public:
+	/**
+	 * @param arg_stream recorded stream
+	 * @param arg_au8_capture capture buffer, recording stops when full
+	 * @param arg_u32_captureSize capture buffer size
+	 * @param arg_u32_baudrate stream baudrate, stored in capture header
+	 */
+	TeleinfoCaptureRecorder(Stream& arg_stream, uint8_t* arg_au8_capture, size_t arg_u32_captureSize, uint32_t arg_u32_baudrate);
+
+	/**
+	 * @return capture length in bytes, header included
+	 */
+	size_t getCaptureLength(void) const {return _u32_captureLength;};
+
+	/**
+	 * @return true when no more byte can be recorded
+	 */
+	bool isFull(void) const {return _u32_captureLength + TeleinfoCapture::RECORD_LENGTH > _u32_captureSize;};
+
+	virtual int available(void);
+	virtual int read(void);
+	virtual int peek(void);
+	virtual void flush(void);
+	virtual size_t write(uint8_t arg_u8_byte);
+};
+
+/**
+ * Stream replaying a capture. Bytes become available according to their
+ * recorded arrival time and replay speed
+ */
+class TeleinfoCaptureStream : public Stream {
+public:
+	typedef enum{
+		/** bytes available at recorded arrival time */
+		REPLAY_REALTIME,
+		/** recorded delays divided by speed factor */
+		REPLAY_ACCELERATED,
+		/** bytes available as soon as read */
+		REPLAY_UNTHROTTLED,
+	}EReplaySpeed;
+
+private:
+	const uint8_t* _au8_capture;
+	size_t _u32_captureLength;
+	/** next record offset in capture */
+	size_t _u32_offset;
+	EReplaySpeed _e_speed;
+	uint16_t _u16_speedFactor;
+	/** replay start time and recorded time of next byte since capture start */
+	uint64_t _u64_startUs;
+	uint64_t _u64_nextByteUs;
+
+public:
+	/**
+	 * @param arg_au8_capture capture, must be kept during replay
+	 * @param arg_u32_captureLength capture length in bytes, header included
+	 */
+	TeleinfoCaptureStream(const uint8_t* arg_au8_capture, size_t arg_u32_captureLength);
+
+	/**
+	 * @return false if capture header is invalid
+	 */
+	bool isValid(void) const;
+
+	/**
+	 * @return capture baudrate, 0 if capture invalid
+	 */
+	uint32_t getBaudrate(void) const;
+
+	/**
+	 * Replay capture from start
+	 * @param arg_e_speed
+	 * @param arg_u16_speedFactor used for REPLAY_ACCELERATED only
+	 */
+	void start(EReplaySpeed arg_e_speed, uint16_t arg_u16_speedFactor = 1);
+
+	/**
+	 * @return true when all recorded bytes have been read
+	 */
+	bool isFinished(void) const {return _u32_offset + TeleinfoCapture::RECORD_LENGTH > _u32_captureLength;};
+
+	virtual int available(void);
+	virtual int read(void);
+	virtual int peek(void);
+	virtual void flush(void);
+	virtual size_t write(uint8_t arg_u8_byte);
+
+private:
+	uint32_t recordDelay(size_t arg_u32_offset) const;
+};
+
+/** Replay results */
+struct TeleinfoReplayReport{
+	uint32_t _u32_nbBytes;
+	uint32_t _u32_nbFrames;
+	uint32_t _u32_nbGroups;
+	/** valid groups not handled by parser */
+	uint32_t _u32_nbIgnoredGroups;
+	uint32_t _u32_nbCRCErrors;
+	/** errors other than CRC errors and ignored groups */
+	uint32_t _u32_nbErrors;
+	/** replay duration */
+	uint32_t _u32_elapsedUs;
+	/** time spent in Teleinfo::feed() for each frame */
+	uint32_t _u32_minFrameParseUs;
+	uint32_t _u32_maxFrameParseUs;
+	uint32_t _u32_totalParseUs;
+
+	/** @return frames per second over replay duration */
+	uint32_t framesPerSecond(void) const {return _u32_elapsedUs ? (uint32_t)((uint64_t) _u32_nbFrames * 1000000 / _u32_elapsedUs) : 0;};
+	/** @return groups per second over replay duration */
+	uint32_t groupsPerSecond(void) const {return _u32_elapsedUs ? (uint32_t)((uint64_t) _u32_nbGroups * 1000000 / _u32_elapsedUs) : 0;};
+	/** @return mean time spent parsing a frame */
+	uint32_t avgFrameParseUs(void) const {return _u32_nbFrames ? _u32_totalParseUs / _u32_nbFrames : 0;};
+};
+
+/**
+ * Feed teleinfo with a whole capture. Blocking until capture replayed
+ * @param arg_teleinfo teleinfo parser, its stream is not used
+ * @param arg_stream started capture stream
+ * @param arg_report replay results
+ */
+void replayTeleinfoCapture(Teleinfo& arg_teleinfo, TeleinfoCaptureStream& arg_stream, TeleinfoReplayReport& arg_report);
+
+#endif /* TELEINFO_TELEINFO_CAPTURE_H_ */
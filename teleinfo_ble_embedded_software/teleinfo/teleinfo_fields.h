@@ -0,0 +1,87 @@
+/******************************************************************************
+ * @file    teleinfo_fields.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo enumerated values - refer
+ * http://norm.edf.fr/pdf/HN44S812emeeditionMars2007.pdf
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_TELEINFO_FIELDS_H_
+#define TELEINFO_TELEINFO_FIELDS_H_
+
+#include <stdint.h>
+
+/** ADCO length */
+static const uint8_t TELEREPORT_HUB_ADDR_LENGTH = 12;
+
+/** Tariff option - OPTARIF */
+typedef enum{
+	/** "BASE" */
+	BASE_TAR = 0,
+	/** "HC.." */
+	HC_TAR,
+	/** "EJP." */
+	EJP_TAR,
+	/** "BBRx" - Tempo, x gives tariff program */
+	TEMPO_TAR,
+	NB_OPT_TAR,
+	/** not received yet or unknown */
+	OPT_TAR_OUT_OF_ENUM
+}EOptTar;
+
+/** Current tariff period - PTEC */
+typedef enum{
+	/** "TH.." - all hours */
+	TH = 0,
+	/** "HC.." - off-peak hours */
+	HC,
+	/** "HP.." - peak hours */
+	HP,
+	/** "HN.." - EJP normal hours */
+	HN,
+	/** "PM.." - EJP mobile peak hours */
+	PM,
+	/** "HCJB" "HPJB" - Tempo blue days off-peak and peak hours */
+	HCJB,
+	HPJB,
+	/** "HCJW" "HPJW" - Tempo white days */
+	HCJW,
+	HPJW,
+	/** "HCJR" "HPJR" - Tempo red days */
+	HCJR,
+	HPJR,
+	NB_PTEC,
+	/** not received yet or unknown */
+	PTEC_OUT_OF_ENUM
+}EPTEC;
+
+/** Tempo day color - DEMAIN */
+typedef enum{
+	/** "----" - tomorrow color not known yet */
+	TEMPO_NO_COLOR = 0,
+	/** "BLEU" */
+	TEMPO_BLUE,
+	/** "BLAN" */
+	TEMPO_WHITE,
+	/** "ROUG" */
+	TEMPO_RED,
+	NB_TEMPO_COLOR,
+	/** not received yet or unknown */
+	TEMPO_COLOR_OUT_OF_ENUM
+}ETempoColor;
+
+#endif /* TELEINFO_TELEINFO_FIELDS_H_ */
@@ -0,0 +1,292 @@
+/******************************************************************************
+ * @file    teleinfo_filter.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo fields changes filtering
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_filter.h"
+#include <delay.h>
+#include <stddef.h>
+#include <logger.h>
+
+/*************************************
+ * Private functions
+ *************************************/
+
+/** @return max of given per phase value */
+static uint32_t maxPhaseValue(const TeleinfoFrame& arg_frame, size_t arg_u32_offset)
+{
+	uint16_t loc_u16_max = 0;
+
+	for(uint8_t loc_u8_phase = 0; loc_u8_phase < TeleinfoFrame::NB_PHASES; loc_u8_phase++)
+	{
+		uint16_t loc_u16_value = *(const uint16_t*)(((const uint8_t*) &arg_frame._phases[loc_u8_phase]) + arg_u32_offset);
+		if(loc_u16_value > loc_u16_max)
+		{
+			loc_u16_max = loc_u16_value;
+		}
+	}
+	return loc_u16_max;
+}
+
+/**
+ * @return numeric value of field, 0 for non numeric fields
+ */
+static uint32_t fieldValue(const TeleinfoFrame& arg_frame, ETeleinfoField arg_e_field)
+{
+	switch(arg_e_field)
+	{
+	case BASE_FIELD :        return arg_frame._u32_baseIndex;
+	case HCHC_FIELD :        return arg_frame._u32_hcIndex;
+	case HCHP_FIELD :        return arg_frame._u32_hpIndex;
+	case EJPHN_FIELD :       return arg_frame._u32_ejpHNIndex;
+	case EJPHPM_FIELD :      return arg_frame._u32_ejpHPMIndex;
+	case BBRHCJB_FIELD :     return arg_frame._u32_bbrHCJBIndex;
+	case BBRHPJB_FIELD :     return arg_frame._u32_bbrHPJBIndex;
+	case BBRHCJW_FIELD :     return arg_frame._u32_bbrHCJWIndex;
+	case BBRHPJW_FIELD :     return arg_frame._u32_bbrHPJWIndex;
+	case BBRHCJR_FIELD :     return arg_frame._u32_bbrHCJRIndex;
+	case BBRHPJR_FIELD :     return arg_frame._u32_bbrHPJRIndex;
+	case GAZ_FIELD :         return arg_frame._u32_gazIndex;
+	case PEJP_FIELD :        return arg_frame._u8_ejpMess;
+	case IINST_FIELD :       return arg_frame._u16_instInt;
+	case IMAX_FIELD :        return arg_frame._u16_maxInt;
+	case ISOUSC_FIELD :      return arg_frame._u16_souscInt;
+	case PAPP_FIELD :        return arg_frame._u32_appPower;
+	case PHASE_IINST_FIELD : return maxPhaseValue(arg_frame, offsetof(TeleinfoPhase, _u16_instInt));
+	case PHASE_IMAX_FIELD :  return maxPhaseValue(arg_frame, offsetof(TeleinfoPhase, _u16_maxInt));
+	case PMAX_FIELD :        return arg_frame._u32_maxPower;
+	case PREF_FIELD :        return arg_frame._u8_refPower;
+	case URMS1_FIELD :       return arg_frame._u16_rmsVoltage;
+	default :                return 0;
+	}
+}
+
+/**
+ * @return true if fieldValue() gives a value changes can be measured on -
+ * must be kept in line with fieldValue()
+ */
+static bool isNumericField(ETeleinfoField arg_e_field)
+{
+	switch(arg_e_field)
+	{
+	case BASE_FIELD :
+	case HCHC_FIELD :
+	case HCHP_FIELD :
+	case EJPHN_FIELD :
+	case EJPHPM_FIELD :
+	case BBRHCJB_FIELD :
+	case BBRHPJB_FIELD :
+	case BBRHCJW_FIELD :
+	case BBRHPJW_FIELD :
+	case BBRHCJR_FIELD :
+	case BBRHPJR_FIELD :
+	case GAZ_FIELD :
+	case PEJP_FIELD :
+	case IINST_FIELD :
+	case IMAX_FIELD :
+	case ISOUSC_FIELD :
+	case PAPP_FIELD :
+	case PHASE_IINST_FIELD :
+	case PHASE_IMAX_FIELD :
+	case PMAX_FIELD :
+	case PREF_FIELD :
+	case URMS1_FIELD :
+		return true;
+	default :
+		return false;
+	}
+}
+
+/*************************************
+ * Method definitions
+ *************************************/
+TeleinfoFilter::TeleinfoFilter(ITeleinfoListener& arg_listener) :
+	_p_listener(&arg_listener),
+	_u8_nbFilters(0),
+	_p_frame(NULL)
+{
+}
+
+bool TeleinfoFilter::setFieldFilter(ETeleinfoField arg_e_field, uint32_t arg_u32_absDeadband, uint16_t arg_u16_relDeadbandPerMille,
+		uint32_t arg_u32_minIntervalMs, uint32_t arg_u32_refreshMs)
+{
+	FieldFilter* loc_p_filter = NULL;
+
+	if(!isNumericField(arg_e_field))
+	{
+		/** every change would be within deadband */
+		return false;
+	}
+
+	/** field already filtered : new settings, filter state restarted */
+	for(uint8_t loc_u8_index = 0; loc_u8_index < _u8_nbFilters; loc_u8_index++)
+	{
+		if(_filters[loc_u8_index]._e_field == arg_e_field)
+		{
+			loc_p_filter = &_filters[loc_u8_index];
+			break;
+		}
+	}
+
+	if(arg_u32_absDeadband == 0 && arg_u16_relDeadbandPerMille == 0 && arg_u32_minIntervalMs == 0 && arg_u32_refreshMs == 0)
+	{
+		/** no filtering : slot freed, field forwarded on each change */
+		if(loc_p_filter != NULL)
+		{
+			*loc_p_filter = _filters[--_u8_nbFilters];
+		}
+		return true;
+	}
+
+	if(loc_p_filter == NULL)
+	{
+		if(_u8_nbFilters == MAX_FILTERED_FIELDS)
+		{
+			return false;
+		}
+		loc_p_filter = &_filters[_u8_nbFilters++];
+	}
+
+	FieldFilter& loc_filter = *loc_p_filter;
+	loc_filter._e_field = arg_e_field;
+	loc_filter._u32_absDeadband = arg_u32_absDeadband;
+	loc_filter._u16_relDeadbandPerMille = arg_u16_relDeadbandPerMille;
+	loc_filter._u32_minIntervalMs = arg_u32_minIntervalMs;
+	loc_filter._u32_refreshMs = arg_u32_refreshMs;
+	loc_filter._b_pending = false;
+	if(_p_frame != NULL)
+	{
+		/** frames already forwarded : listener has current value, seed filter with it so that refresh goes on */
+		loc_filter._u32_lastValue = fieldValue(*_p_frame, arg_e_field);
+		loc_filter._u32_lastEmitMs = millis();
+		loc_filter._b_emitted = true;
+	}
+	else
+	{
+		loc_filter._u32_lastValue = 0;
+		loc_filter._u32_lastEmitMs = 0;
+		loc_filter._b_emitted = false;
+	}
+	return true;
+}
+
+void TeleinfoFilter::onFrame(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask)
+{
+	uint32_t loc_u32_nowMs = millis();
+	TeleinfoFieldMask loc_mask = arg_changedMask;
+
+	_p_frame = &arg_frame;
+
+	for(uint8_t loc_u8_index = 0; loc_u8_index < _u8_nbFilters; loc_u8_index++)
+	{
+		FieldFilter& loc_filter = _filters[loc_u8_index];
+		TeleinfoFieldMask loc_fieldMask = teleinfoFieldMask(loc_filter._e_field);
+
+		if(mustEmit(loc_filter, fieldValue(arg_frame, loc_filter._e_field), arg_changedMask & loc_fieldMask, loc_u32_nowMs))
+		{
+			loc_mask |= loc_fieldMask;
+		}
+		else
+		{
+			loc_mask &= ~loc_fieldMask;
+		}
+	}
+
+	if(loc_mask)
+	{
+		_p_listener->onFrame(arg_frame, loc_mask);
+	}
+}
+
+void TeleinfoFilter::refresh(void)
+{
+	uint32_t loc_u32_nowMs = millis();
+	TeleinfoFieldMask loc_mask = 0;
+
+	if(_p_frame == NULL)
+	{
+		return;
+	}
+
+	for(uint8_t loc_u8_index = 0; loc_u8_index < _u8_nbFilters; loc_u8_index++)
+	{
+		FieldFilter& loc_filter = _filters[loc_u8_index];
+		if(mustEmit(loc_filter, fieldValue(*_p_frame, loc_filter._e_field), false, loc_u32_nowMs))
+		{
+			loc_mask |= teleinfoFieldMask(loc_filter._e_field);
+		}
+	}
+
+	if(loc_mask)
+	{
+		_p_listener->onFrame(*_p_frame, loc_mask);
+	}
+}
+
+bool TeleinfoFilter::mustEmit(FieldFilter& arg_filter, uint32_t arg_u32_value, bool arg_b_changed, uint32_t arg_u32_nowMs)
+{
+	uint32_t loc_u32_elapsedMs = arg_u32_nowMs - arg_filter._u32_lastEmitMs;
+	bool loc_b_emit = false;
+
+	if(!arg_filter._b_emitted)
+	{
+		loc_b_emit = arg_b_changed;
+	}
+	else if(arg_filter._u32_refreshMs != 0 && loc_u32_elapsedMs >= arg_filter._u32_refreshMs)
+	{
+		loc_b_emit = true;
+	}
+	else
+	{
+		if(arg_b_changed)
+		{
+			uint32_t loc_u32_delta = (arg_u32_value > arg_filter._u32_lastValue) ?
+					arg_u32_value - arg_filter._u32_lastValue : arg_filter._u32_lastValue - arg_u32_value;
+			uint32_t loc_u32_deadband = (uint32_t)(((uint64_t) arg_filter._u32_lastValue * arg_filter._u16_relDeadbandPerMille) / 1000);
+
+			if(arg_filter._u32_absDeadband > loc_u32_deadband)
+			{
+				loc_u32_deadband = arg_filter._u32_absDeadband;
+			}
+
+			/**
+			 * Hysteresis : a delayed change is only cancelled once value is back
+			 * within half of deadband, not on jitter around deadband edge
+			 */
+			if(loc_u32_delta > loc_u32_deadband)
+			{
+				arg_filter._b_pending = true;
+			}
+			else if(loc_u32_delta <= loc_u32_deadband / HYSTERESIS_DIVIDER)
+			{
+				arg_filter._b_pending = false;
+			}
+		}
+		loc_b_emit = arg_filter._b_pending && loc_u32_elapsedMs >= arg_filter._u32_minIntervalMs;
+	}
+
+	if(loc_b_emit)
+	{
+		arg_filter._u32_lastValue = arg_u32_value;
+		arg_filter._u32_lastEmitMs = arg_u32_nowMs;
+		arg_filter._b_emitted = true;
+		arg_filter._b_pending = false;
+	}
+	return loc_b_emit;
+}
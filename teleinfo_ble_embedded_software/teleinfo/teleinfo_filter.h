@@ -0,0 +1,104 @@
+/******************************************************************************
+ * @file    teleinfo_filter.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo listener filtering numeric fields changes with deadbands and
+ * emission intervals before forwarding frames to another listener, so that
+ * only meaningful changes are notified
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_TELEINFO_FILTER_H_
+#define TELEINFO_TELEINFO_FILTER_H_
+
+#include <stdint.h>
+#include "teleinfo_listener.h"
+
+class TeleinfoFilter : public ITeleinfoListener {
+public:
+	/** max number of fields filtered */
+	static const uint8_t MAX_FILTERED_FIELDS = 8;
+	/** delayed change cancelled when value back within deadband / HYSTERESIS_DIVIDER */
+	static const uint8_t HYSTERESIS_DIVIDER = 2;
+
+private:
+	struct FieldFilter{
+		ETeleinfoField _e_field;
+		/** change notified if greater than both deadbands */
+		uint32_t _u32_absDeadband;
+		uint16_t _u16_relDeadbandPerMille;
+		/** min time between two notifications, 0 if none */
+		uint32_t _u32_minIntervalMs;
+		/** value notified again after this time even if unchanged, 0 if never */
+		uint32_t _u32_refreshMs;
+
+		uint32_t _u32_lastValue;
+		uint32_t _u32_lastEmitMs;
+		bool _b_emitted;
+		/** meaningful change not notified yet because of min interval */
+		bool _b_pending;
+	};
+
+	ITeleinfoListener* _p_listener;
+	FieldFilter _filters[MAX_FILTERED_FIELDS];
+	uint8_t _u8_nbFilters;
+	/** last frame notified by teleinfo, NULL before first frame */
+	const TeleinfoFrame* _p_frame;
+
+public:
+	/**
+	 * @param arg_listener listener frames are forwarded to - fields not
+	 * filtered are forwarded on each change
+	 */
+	TeleinfoFilter(ITeleinfoListener& arg_listener);
+	virtual ~TeleinfoFilter(void){};
+
+	/**
+	 * Filter a numeric field - for per phase fields, max of all phases is
+	 * filtered. Replaces settings of an already filtered field. Once a frame
+	 * has been forwarded, filter starts from current field value. All
+	 * settings 0 removes field filter
+	 * @param arg_e_field
+	 * @param arg_u32_absDeadband change notified if greater than this value...
+	 * @param arg_u16_relDeadbandPerMille ...and than this ratio of last
+	 * notified value
+	 * @param arg_u32_minIntervalMs min time between two notifications of field
+	 * @param arg_u32_refreshMs field notified again after this time even if
+	 * unchanged, 0 if never
+	 * @return false if field is not numeric or MAX_FILTERED_FIELDS other
+	 * fields already filtered
+	 */
+	bool setFieldFilter(ETeleinfoField arg_e_field, uint32_t arg_u32_absDeadband, uint16_t arg_u16_relDeadbandPerMille,
+			uint32_t arg_u32_minIntervalMs, uint32_t arg_u32_refreshMs);
+
+	/**
+	 * Notify fields whose refresh period elapsed, or whose change was delayed by
+	 * min interval, when no frame changed them. Must be called periodically
+	 */
+	void refresh(void);
+
+	/** from ITeleinfoListener */
+	void onFrame(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask);
+
+private:
+	/**
+	 * @return true if field must be notified now
+	 * @param arg_b_changed field changed in notified frame
+	 */
+	bool mustEmit(FieldFilter& arg_filter, uint32_t arg_u32_value, bool arg_b_changed, uint32_t arg_u32_nowMs);
+};
+
+#endif /* TELEINFO_TELEINFO_FILTER_H_ */
@@ -0,0 +1,215 @@
+/******************************************************************************
+ * @file    teleinfo_frame.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo values decoded from frames - refer
+ * http://norm.edf.fr/pdf/HN44S812emeeditionMars2007.pdf
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_TELEINFO_FRAME_H_
+#define TELEINFO_TELEINFO_FRAME_H_
+
+#include <stdint.h>
+#include "teleinfo_fields.h"
+
+/** TeleinfoFrame values - bit index in TeleinfoFieldMask */
+typedef enum{
+	ADCO_FIELD = 0,
+	OPTARIF_FIELD,
+	BASE_FIELD,
+	HCHC_FIELD,
+	HCHP_FIELD,
+	EJPHN_FIELD,
+	EJPHPM_FIELD,
+	PEJP_FIELD,
+	GAZ_FIELD,
+	PTEC_FIELD,
+	MOTDETAT_FIELD,
+	IINST_FIELD,
+	IMAX_FIELD,
+	ISOUSC_FIELD,
+	PAPP_FIELD,
+	HHPHC_FIELD,
+	/** three-phase - one bit for all phases */
+	PHASE_IINST_FIELD,
+	PHASE_IMAX_FIELD,
+	/** set on each ADIR received, even if value unchanged */
+	ADIR_FIELD,
+	PMAX_FIELD,
+	PPOT_FIELD,
+	/** Tempo */
+	BBRHCJB_FIELD,
+	BBRHPJB_FIELD,
+	BBRHCJW_FIELD,
+	BBRHPJW_FIELD,
+	BBRHCJR_FIELD,
+	BBRHPJR_FIELD,
+	DEMAIN_FIELD,
+	/** standard mode */
+	NGTF_FIELD,
+	LTARF_FIELD,
+	NTARF_FIELD,
+	PREF_FIELD,
+	URMS1_FIELD,
+	STGE_FIELD,
+	NB_TELEINFO_FIELDS
+}ETeleinfoField;
+
+/** 1 bit per ETeleinfoField */
+typedef uint64_t TeleinfoFieldMask;
+
+static_assert(NB_TELEINFO_FIELDS <= 8 * sizeof(TeleinfoFieldMask), "TeleinfoFieldMask too small");
+
+/** @return mask of given field */
+constexpr TeleinfoFieldMask teleinfoFieldMask(ETeleinfoField arg_e_field)
+{
+	return ((TeleinfoFieldMask) 1) << arg_e_field;
+}
+
+static const TeleinfoFieldMask ALL_TELEINFO_FIELDS = (NB_TELEINFO_FIELDS == 64) ? ~((TeleinfoFieldMask) 0) : (((TeleinfoFieldMask) 1 << (NB_TELEINFO_FIELDS % 64)) - 1);
+
+/** three-phase meter values of one phase */
+struct TeleinfoPhase{
+	/** IINSTn - A */
+	uint16_t _u16_instInt;
+	/** IMAXn - A */
+	uint16_t _u16_maxInt;
+	/** ADIRn - A, overcurrent only sent in short frames, 0 otherwise */
+	uint16_t _u16_overInt;
+};
+
+/**
+ * Snapshot of teleinfo values. Each value is the last one received with a
+ * valid CRC
+ */
+struct TeleinfoFrame{
+	/*****************************
+	 * Teleinfo fields size
+	 *****************************/
+	static const uint8_t OP_TAR_LENGTH                  = 4;
+	static const uint8_t INDEX_LENGTH                   = 9;
+	static const uint8_t GAZ_INDEX_LENGTH               = 7;
+	static const uint8_t PTEC_LENGTH                    = 4;
+	static const uint8_t MOD_ETAT_LENGTH                = 6;
+	static const uint8_t CURR_INT_LENGTH                = 3;
+	static const uint8_t INT_LENGTH                     = 2;
+	static const uint8_t PTEC_MESS_LENGTH               = 2;
+	static const uint8_t POWER_LENGTH                   = 5;
+	static const uint8_t HHPHC_LENGTH                   = 1;
+	/** three-phase */
+	static const uint8_t NB_PHASES                      = 3;
+	static const uint8_t MAX_POWER_LENGTH               = 5;
+	static const uint8_t POTENTIALS_LENGTH              = 2;
+	/** Tempo */
+	static const uint8_t COLOR_LENGTH                   = 4;
+	/** standard mode */
+	static const uint8_t TARIFF_NAME_LENGTH             = 16;
+	static const uint8_t TARIFF_INDEX_LENGTH            = 2;
+	static const uint8_t REF_POWER_LENGTH               = 2;
+	static const uint8_t VOLTAGE_LENGTH                 = 3;
+	static const uint8_t STATUS_LENGTH                  = 8;
+
+	/*********************************************
+	 * teleinfo fields on client power meter side
+	 ********************************************/
+	/** ADCO - +1 for null char */
+	char _as8_hubAddr[TELEREPORT_HUB_ADDR_LENGTH + 1];
+	/** OPTARIF - EOptTar */
+	uint8_t _u8_optTar;
+	/** BASE - Wh */
+	uint32_t _u32_baseIndex;
+	/** HCHC - Wh */
+	uint32_t _u32_hcIndex;
+	/** HCHP - Wh */
+	uint32_t _u32_hpIndex;
+	/** EJPHN - Wh */
+	uint32_t _u32_ejpHNIndex;
+	/** EJPHPM - Wh */
+	uint32_t _u32_ejpHPMIndex;
+	/** BBRHCJB - Wh */
+	uint32_t _u32_bbrHCJBIndex;
+	/** BBRHPJB - Wh */
+	uint32_t _u32_bbrHPJBIndex;
+	/** BBRHCJW - Wh */
+	uint32_t _u32_bbrHCJWIndex;
+	/** BBRHPJW - Wh */
+	uint32_t _u32_bbrHPJWIndex;
+	/** BBRHCJR - Wh */
+	uint32_t _u32_bbrHCJRIndex;
+	/** BBRHPJR - Wh */
+	uint32_t _u32_bbrHPJRIndex;
+	/** PEJP - min */
+	uint8_t _u8_ejpMess;
+	/** GAZ - dal */
+	uint32_t _u32_gazIndex;
+	/** PTEC - EPTEC */
+	uint8_t _u8_currTar;
+	/** DEMAIN - ETempoColor */
+	uint8_t _u8_tomorrowColor;
+	/** MOTDETAT - +1 for null char */
+	char _as8_modEtat[MOD_ETAT_LENGTH + 1];
+	/** IINST - A */
+	uint16_t _u16_instInt;
+	/** IMAX - A */
+	uint16_t _u16_maxInt;
+	/** ISOUSC - A */
+	uint16_t _u16_souscInt;
+	/** PAPP - VA */
+	uint32_t _u32_appPower;
+	/** HHPHC */
+	char _s8_hhphc;
+
+	/*********************************************
+	 * three-phase meters only fields - single
+	 * phase fields IINST IMAX are not sent
+	 ********************************************/
+	TeleinfoPhase _phases[NB_PHASES];
+	/** PMAX - W */
+	uint32_t _u32_maxPower;
+	/** PPOT - bit n set when phase n potential absent */
+	uint8_t _u8_potentials;
+	/**
+	 * true when frame is a short frame sent on overcurrent - only ADIRn and
+	 * IINSTn values are then up to date
+	 */
+	bool _b_shortFrame;
+	/**
+	 * true when some groups of frame were invalid and skipped - values of
+	 * valid groups are up to date
+	 */
+	bool _b_partialFrame;
+
+	/*********************************************
+	 * standard mode only fields - standard fields
+	 * with an historic equivalent are stored in
+	 * historic field
+	 ********************************************/
+	/** NGTF - +1 for null char */
+	char _as8_tariffName[TARIFF_NAME_LENGTH + 1];
+	/** LTARF - +1 for null char */
+	char _as8_tariffLabel[TARIFF_NAME_LENGTH + 1];
+	/** NTARF */
+	uint8_t _u8_tariffIndex;
+	/** PREF - kVA */
+	uint8_t _u8_refPower;
+	/** URMS1 - V */
+	uint16_t _u16_rmsVoltage;
+	/** STGE */
+	uint32_t _u32_status;
+};
+
+#endif /* TELEINFO_TELEINFO_FRAME_H_ */
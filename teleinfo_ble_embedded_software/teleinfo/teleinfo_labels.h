@@ -0,0 +1,113 @@
+/******************************************************************************
+ * @file    teleinfo_labels.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo group labels resolved at compile time. A label is packed in
+ * a 64 bits integer key (first char in LSB), keys are dispatched with a
+ * multiplicative hash checked at compile time to be collision free for each
+ * labels table, so
+ * resolving a received label costs one multiply, one table read and one
+ * integer compare.
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_TELEINFO_LABELS_H_
+#define TELEINFO_TELEINFO_LABELS_H_
+
+#include <stdint.h>
+
+namespace TeleinfoLabels
+{
+	/** labels longer than this are never handled */
+	static const uint8_t KEY_MAX_LENGTH   = 8;
+	/** label not in table */
+	static const uint8_t NO_ENTRY         = 0xFF;
+	/** 64 slots - TELEINFO_LABEL_SLOTS expects 64 slots */
+	static const uint8_t HASH_BITS        = 6;
+
+	/**
+	 * Pack a label in an integer key, first char in LSB
+	 * @param arg_as8_label null terminated label
+	 * @return key
+	 */
+	constexpr uint64_t pack(const char* arg_as8_label, uint8_t arg_u8_index = 0)
+	{
+		return (arg_u8_index == KEY_MAX_LENGTH || arg_as8_label[arg_u8_index] == '\0') ? 0 :
+				(((uint64_t)(uint8_t) arg_as8_label[arg_u8_index]) << (8 * arg_u8_index)) | pack(arg_as8_label, arg_u8_index + 1);
+	}
+
+	/**
+	 * @param arg_u64_key packed label
+	 * @param arg_u32_mult table hash multiplier - found offline for each labels
+	 * table, must be changed when a label is added and isPerfect() fails
+	 * @return slot in dispatch table
+	 */
+	constexpr uint8_t slot(uint64_t arg_u64_key, uint32_t arg_u32_mult)
+	{
+		return (uint8_t)((uint32_t)(((uint32_t) arg_u64_key ^ (uint32_t)(arg_u64_key >> 32)) * arg_u32_mult) >> (32 - HASH_BITS));
+	}
+
+	/**
+	 * @param arg_p_table labels table - entries have a _u64_label packed label
+	 * @return table entry whose label goes in given slot, NO_ENTRY if none
+	 */
+	template <class T>
+	constexpr uint8_t entryInSlot(const T* arg_p_table, uint8_t arg_u8_nbEntries, uint32_t arg_u32_mult, uint8_t arg_u8_slot, uint8_t arg_u8_entry = 0)
+	{
+		return arg_u8_entry == arg_u8_nbEntries ? NO_ENTRY :
+				slot(arg_p_table[arg_u8_entry]._u64_label, arg_u32_mult) == arg_u8_slot ? arg_u8_entry : entryInSlot(arg_p_table, arg_u8_nbEntries, arg_u32_mult, arg_u8_slot, arg_u8_entry + 1);
+	}
+
+	/** @return number of table entries whose label goes in given slot */
+	template <class T>
+	constexpr uint8_t nbEntriesInSlot(const T* arg_p_table, uint8_t arg_u8_nbEntries, uint32_t arg_u32_mult, uint8_t arg_u8_slot, uint8_t arg_u8_entry = 0)
+	{
+		return arg_u8_entry == arg_u8_nbEntries ? 0 :
+				(slot(arg_p_table[arg_u8_entry]._u64_label, arg_u32_mult) == arg_u8_slot ? 1 : 0) + nbEntriesInSlot(arg_p_table, arg_u8_nbEntries, arg_u32_mult, arg_u8_slot, arg_u8_entry + 1);
+	}
+
+	/** @return true if no 2 labels of table share a slot */
+	template <class T>
+	constexpr bool isPerfect(const T* arg_p_table, uint8_t arg_u8_nbEntries, uint32_t arg_u32_mult, uint8_t arg_u8_entry = 0)
+	{
+		return arg_u8_entry == arg_u8_nbEntries ? true :
+				nbEntriesInSlot(arg_p_table, arg_u8_nbEntries, arg_u32_mult, slot(arg_p_table[arg_u8_entry]._u64_label, arg_u32_mult)) == 1 && isPerfect(arg_p_table, arg_u8_nbEntries, arg_u32_mult, arg_u8_entry + 1);
+	}
+
+	/**
+	 * @param arg_p_table labels table
+	 * @param arg_au8_slots slots built with TELEINFO_LABEL_SLOTS from same table
+	 * @param arg_u32_mult table hash multiplier
+	 * @param arg_u64_key received packed label
+	 * @return table entry matching label, NO_ENTRY if label not handled
+	 */
+	template <class T>
+	inline uint8_t lookup(const T* arg_p_table, const uint8_t* arg_au8_slots, uint32_t arg_u32_mult, uint64_t arg_u64_key)
+	{
+		uint8_t loc_u8_entry = arg_au8_slots[slot(arg_u64_key, arg_u32_mult)];
+		return (loc_u8_entry != NO_ENTRY && arg_p_table[loc_u8_entry]._u64_label == arg_u64_key) ? loc_u8_entry : NO_ENTRY;
+	}
+}
+
+/** Initializer of a dispatch table - slot to table entry - for given labels table */
+#define TELEINFO_LABEL_SLOTS_4(t, nb, m, n)  TeleinfoLabels::entryInSlot(t, nb, m, n), TeleinfoLabels::entryInSlot(t, nb, m, n + 1), \
+	TeleinfoLabels::entryInSlot(t, nb, m, n + 2), TeleinfoLabels::entryInSlot(t, nb, m, n + 3)
+#define TELEINFO_LABEL_SLOTS_16(t, nb, m, n) TELEINFO_LABEL_SLOTS_4(t, nb, m, n), TELEINFO_LABEL_SLOTS_4(t, nb, m, n + 4), \
+	TELEINFO_LABEL_SLOTS_4(t, nb, m, n + 8), TELEINFO_LABEL_SLOTS_4(t, nb, m, n + 12)
+#define TELEINFO_LABEL_SLOTS(t, nb, m) {TELEINFO_LABEL_SLOTS_16(t, nb, m, 0), TELEINFO_LABEL_SLOTS_16(t, nb, m, 16), \
+	TELEINFO_LABEL_SLOTS_16(t, nb, m, 32), TELEINFO_LABEL_SLOTS_16(t, nb, m, 48)}
+
+#endif /* TELEINFO_TELEINFO_LABELS_H_ */
@@ -0,0 +1,200 @@
+/******************************************************************************
+ * @file    teleinfo_power.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Real power estimation from energy indexes increments
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_power.h"
+#include <delay.h>
+#include <logger.h>
+#include <string.h>
+
+/*************************************
+ * Static definitions
+ *************************************/
+#define MS_PER_HOUR 3600000UL
+
+const TeleinfoFieldMask TeleinfoPowerEstimator::ESTIMATED_FIELDS = teleinfoFieldMask(BASE_FIELD) | teleinfoFieldMask(HCHC_FIELD)
+		| teleinfoFieldMask(HCHP_FIELD) | teleinfoFieldMask(EJPHN_FIELD) | teleinfoFieldMask(EJPHPM_FIELD)
+		| teleinfoFieldMask(BBRHCJB_FIELD) | teleinfoFieldMask(BBRHPJB_FIELD) | teleinfoFieldMask(BBRHCJW_FIELD)
+		| teleinfoFieldMask(BBRHPJW_FIELD) | teleinfoFieldMask(BBRHCJR_FIELD) | teleinfoFieldMask(BBRHPJR_FIELD)
+		| teleinfoFieldMask(PTEC_FIELD);
+
+/*************************************
+ * Private functions
+ *************************************/
+
+/**
+ * Read energy indexes of frame. In standard mode EAST total index is stored in
+ * BASE and EASF01/02 tariff indexes in HCHC/HCHP : BASE used alone when received
+ * so that energy is not counted twice
+ * @param arg_au32_indexes indexes read, 0 if not used
+ * @return indexes used, bit n for arg_au32_indexes[n]
+ */
+static uint16_t readIndexes(const TeleinfoFrame& arg_frame, uint32_t arg_au32_indexes[TeleinfoPowerEstimator::NB_INDEXES])
+{
+	uint16_t loc_u16_indexMask = 0;
+
+	arg_au32_indexes[0] = arg_frame._u32_baseIndex;
+	arg_au32_indexes[1] = arg_frame._u32_hcIndex;
+	arg_au32_indexes[2] = arg_frame._u32_hpIndex;
+	arg_au32_indexes[3] = arg_frame._u32_ejpHNIndex;
+	arg_au32_indexes[4] = arg_frame._u32_ejpHPMIndex;
+	arg_au32_indexes[5] = arg_frame._u32_bbrHCJBIndex;
+	arg_au32_indexes[6] = arg_frame._u32_bbrHPJBIndex;
+	arg_au32_indexes[7] = arg_frame._u32_bbrHCJWIndex;
+	arg_au32_indexes[8] = arg_frame._u32_bbrHPJWIndex;
+	arg_au32_indexes[9] = arg_frame._u32_bbrHCJRIndex;
+	arg_au32_indexes[10] = arg_frame._u32_bbrHPJRIndex;
+
+	if(arg_au32_indexes[0] != 0)
+	{
+		memset(&arg_au32_indexes[1], 0, (TeleinfoPowerEstimator::NB_INDEXES - 1) * sizeof(arg_au32_indexes[0]));
+		return 1;
+	}
+
+	for(uint8_t loc_u8_index = 1; loc_u8_index < TeleinfoPowerEstimator::NB_INDEXES; loc_u8_index++)
+	{
+		if(arg_au32_indexes[loc_u8_index] != 0)
+		{
+			loc_u16_indexMask |= 1 << loc_u8_index;
+		}
+	}
+	return loc_u16_indexMask;
+}
+
+/*************************************
+ * Method definitions
+ *************************************/
+TeleinfoPowerEstimator::TeleinfoPowerEstimator(void) :
+	_u16_indexMask(0),
+	_u32_energyWh(0),
+	_u8_currTar(PTEC_OUT_OF_ENUM),
+	_b_started(false),
+	_b_measuring(false),
+	_u64_measureStartMs(0),
+	_u32_measureStartWh(0),
+	_u64_lastStepMs(0),
+	_u32_realPowerW(0),
+	_b_valid(false)
+{
+	memset(_au32_indexes, 0, sizeof(_au32_indexes));
+}
+
+uint32_t TeleinfoPowerEstimator::getRealPower(void) const
+{
+	uint64_t loc_u64_sinceStepMs;
+
+	if(!_b_valid)
+	{
+		return INVALID_POWER;
+	}
+
+	loc_u64_sinceStepMs = millis64() - _u64_lastStepMs;
+	if(loc_u64_sinceStepMs <= FRAME_PERIOD_MARGIN_MS)
+	{
+		return _u32_realPowerW;
+	}
+	loc_u64_sinceStepMs -= FRAME_PERIOD_MARGIN_MS;
+	if(MS_PER_HOUR / loc_u64_sinceStepMs < _u32_realPowerW)
+	{
+		return (uint32_t)(MS_PER_HOUR / loc_u64_sinceStepMs);
+	}
+	return _u32_realPowerW;
+}
+
+void TeleinfoPowerEstimator::onFrame(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask)
+{
+	uint64_t loc_u64_nowMs = millis64();
+	uint32_t loc_au32_indexes[NB_INDEXES];
+	uint16_t loc_u16_indexMask = readIndexes(arg_frame, loc_au32_indexes);
+	bool loc_b_continuous = _b_started && loc_u16_indexMask == _u16_indexMask && arg_frame._u8_currTar == _u8_currTar;
+	uint32_t loc_u32_stepWh = 0;
+	uint32_t loc_u32_measureMs;
+	uint32_t loc_u32_powerW;
+
+	/** indexes increments summed rather than indexes : no overflow on big indexes */
+	for(uint8_t loc_u8_index = 0; loc_u8_index < NB_INDEXES; loc_u8_index++)
+	{
+		if(loc_au32_indexes[loc_u8_index] < _au32_indexes[loc_u8_index])
+		{
+			loc_b_continuous = false;
+		}
+		loc_u32_stepWh += loc_au32_indexes[loc_u8_index] - _au32_indexes[loc_u8_index];
+	}
+	memcpy(_au32_indexes, loc_au32_indexes, sizeof(_au32_indexes));
+
+	/**
+	 * First frame, index appearing or going backwards : increments not known.
+	 * Tariff period switch : switch frame may carry old period index last
+	 * increment, measure timing not reliable
+	 */
+	if(!loc_b_continuous)
+	{
+		if(_b_started && arg_frame._u8_currTar != _u8_currTar)
+		{
+			LOG_DEBUG_LN("tariff period switch - power measure restarted");
+		}
+		_b_started = true;
+		_u16_indexMask = loc_u16_indexMask;
+		_u8_currTar = arg_frame._u8_currTar;
+		restartMeasure();
+		return;
+	}
+
+	if(loc_u32_stepWh == 0)
+	{
+		return;
+	}
+	_u32_energyWh += loc_u32_stepWh;
+	_u64_lastStepMs = loc_u64_nowMs;
+
+	/** index increment seen : time origin of a measure */
+	if(!_b_measuring)
+	{
+		_b_measuring = true;
+		_u64_measureStartMs = loc_u64_nowMs;
+		_u32_measureStartWh = _u32_energyWh;
+		return;
+	}
+
+	/** an increment is only known at frame resolution, measure over several */
+	loc_u32_measureMs = (uint32_t)(loc_u64_nowMs - _u64_measureStartMs);
+	if(loc_u32_measureMs < MIN_MEASURE_MS)
+	{
+		return;
+	}
+
+	loc_u32_powerW = (uint32_t)(((uint64_t)(_u32_energyWh - _u32_measureStartWh) * MS_PER_HOUR) / loc_u32_measureMs);
+	if(_b_valid)
+	{
+		_u32_realPowerW = (uint32_t)((((uint64_t) _u32_realPowerW << SMOOTHING_SHIFT) - _u32_realPowerW + loc_u32_powerW) >> SMOOTHING_SHIFT);
+	}
+	else
+	{
+		_u32_realPowerW = loc_u32_powerW;
+		_b_valid = true;
+	}
+	_u64_measureStartMs = loc_u64_nowMs;
+	_u32_measureStartWh = _u32_energyWh;
+}
+
+void TeleinfoPowerEstimator::restartMeasure(void)
+{
+	_b_measuring = false;
+}
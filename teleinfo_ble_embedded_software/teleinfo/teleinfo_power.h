@@ -0,0 +1,90 @@
+/******************************************************************************
+ * @file    teleinfo_power.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo listener estimating real power from energy indexes
+ * increments - PAPP is an apparent power rounded to 10VA
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_TELEINFO_POWER_H_
+#define TELEINFO_TELEINFO_POWER_H_
+
+#include <stdint.h>
+#include "teleinfo_listener.h"
+
+class TeleinfoPowerEstimator : public ITeleinfoListener {
+public:
+	/** returned when no estimate available */
+	static const uint32_t INVALID_POWER = 0xFFFFFFFF;
+
+	/** fields estimator must be registered for */
+	static const TeleinfoFieldMask ESTIMATED_FIELDS;
+
+	/** min time between two index increments used for an estimate - ms */
+	static const uint32_t MIN_MEASURE_MS = 30000;
+	/** estimates exponentially smoothed with a 1 / 2^SMOOTHING_SHIFT weight */
+	static const uint8_t SMOOTHING_SHIFT = 2;
+	/** increments are seen at frame resolution - bound allows one frame delay */
+	static const uint32_t FRAME_PERIOD_MARGIN_MS = 2000;
+
+	/** BASE, HCHC, HCHP, EJPHN, EJPHPM and Tempo indexes */
+	static const uint8_t NB_INDEXES = 11;
+
+private:
+	/** energy indexes in last frame - Wh */
+	uint32_t _au32_indexes[NB_INDEXES];
+	/** energy indexes received in last frame, bit n for _au32_indexes[n] */
+	uint16_t _u16_indexMask;
+	/** sum of indexes increments since start - Wh, wraps */
+	uint32_t _u32_energyWh;
+	/** PTEC in last frame */
+	uint8_t _u8_currTar;
+	/** at least one frame received */
+	bool _b_started;
+
+	/** measure starts on an index increment */
+	bool _b_measuring;
+	uint64_t _u64_measureStartMs;
+	uint32_t _u32_measureStartWh;
+	/** last index increment */
+	uint64_t _u64_lastStepMs;
+
+	/** smoothed estimate - W */
+	uint32_t _u32_realPowerW;
+	bool _b_valid;
+
+public:
+	TeleinfoPowerEstimator(void);
+	virtual ~TeleinfoPowerEstimator(void){};
+
+	/**
+	 * Real power estimate. Between two increments, less than 1Wh has been
+	 * consumed since last increment : estimate is bounded accordingly so that
+	 * it decreases when consumption stops
+	 * @return real power - W, INVALID_POWER if not estimated yet
+	 */
+	uint32_t getRealPower(void) const;
+
+	/** from ITeleinfoListener */
+	void onFrame(const TeleinfoFrame& arg_frame, TeleinfoFieldMask arg_changedMask);
+
+private:
+	/** restart measure from next index increment, estimate kept */
+	void restartMeasure(void);
+};
+
+#endif /* TELEINFO_TELEINFO_POWER_H_ */
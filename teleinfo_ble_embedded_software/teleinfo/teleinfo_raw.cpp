@@ -0,0 +1,135 @@
+/******************************************************************************
+ * @file    teleinfo_raw.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Raw teleinfo frames capture
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_raw.h"
+#include <string.h>
+#include <logger.h>
+
+TeleinfoRawCapture::TeleinfoRawCapture(uint8_t arg_u8_chunkLength) :
+	_p_filled(NULL),
+	_p_ready(NULL),
+	_u16_readPos(0),
+	_u8_chunkIndex(0),
+	_u8_frameSeq(0),
+	_u8_readySeq(0),
+	_u8_chunkDataLength(arg_u8_chunkLength - CHUNK_HEADER_LENGTH),
+	_u32_nbDroppedFrames(0)
+{
+	ASSERT(arg_u8_chunkLength > CHUNK_HEADER_LENGTH);
+	/** chunk index must not reach flags */
+	ASSERT((MAX_FRAME_LENGTH + _u8_chunkDataLength - 1) / _u8_chunkDataLength <= TRUNCATED_FLAG);
+}
+
+void TeleinfoRawCapture::feed(const uint8_t* arg_au8_bytes, size_t arg_u32_nbBytes)
+{
+	for(size_t loc_u32_index = 0; loc_u32_index < arg_u32_nbBytes; loc_u32_index++)
+	{
+		/** transmission on 7 bits - parity bit not forwarded */
+		uint8_t loc_u8_byte = arg_au8_bytes[loc_u32_index] & 0x7F;
+
+		if(loc_u8_byte == START_TEXT)
+		{
+			/** fill buffer not read out - STX while filling restarts frame */
+			_p_filled = (_p_ready == &_buffers[0]) ? &_buffers[1] : &_buffers[0];
+			_p_filled->_u16_length = 0;
+			_p_filled->_b_truncated = false;
+		}
+
+		if(_p_filled == NULL)
+		{
+			continue;
+		}
+
+		if(_p_filled->_u16_length < MAX_FRAME_LENGTH)
+		{
+			_p_filled->_au8_bytes[_p_filled->_u16_length++] = loc_u8_byte;
+		}
+		else
+		{
+			_p_filled->_b_truncated = true;
+		}
+
+		if(loc_u8_byte == END_TEXT)
+		{
+			if(_p_ready == NULL)
+			{
+				_p_ready = _p_filled;
+				_u16_readPos = 0;
+				_u8_chunkIndex = 0;
+				_u8_readySeq = _u8_frameSeq;
+			}
+			else
+			{
+				_u32_nbDroppedFrames++;
+			}
+			/** dropped frames sequence numbers are skipped, receiver sees the gap */
+			_u8_frameSeq++;
+			_p_filled = NULL;
+		}
+	}
+}
+
+void TeleinfoRawCapture::reset(void)
+{
+	_p_filled = NULL;
+	_p_ready = NULL;
+}
+
+uint8_t TeleinfoRawCapture::peekChunk(uint8_t arg_au8_chunk[]) const
+{
+	uint16_t loc_u16_length;
+
+	if(_p_ready == NULL)
+	{
+		return 0;
+	}
+
+	loc_u16_length = _p_ready->_u16_length - _u16_readPos;
+	if(loc_u16_length > _u8_chunkDataLength)
+	{
+		loc_u16_length = _u8_chunkDataLength;
+	}
+
+	arg_au8_chunk[0] = _u8_readySeq;
+	arg_au8_chunk[1] = _u8_chunkIndex;
+	if(_u16_readPos + loc_u16_length == _p_ready->_u16_length)
+	{
+		arg_au8_chunk[1] |= LAST_CHUNK_FLAG | (_p_ready->_b_truncated ? TRUNCATED_FLAG : 0);
+	}
+	memcpy(&arg_au8_chunk[CHUNK_HEADER_LENGTH], &_p_ready->_au8_bytes[_u16_readPos], loc_u16_length);
+
+	return loc_u16_length + CHUNK_HEADER_LENGTH;
+}
+
+void TeleinfoRawCapture::releaseChunk(void)
+{
+	if(_p_ready == NULL)
+	{
+		return;
+	}
+
+	_u16_readPos += _u8_chunkDataLength;
+	_u8_chunkIndex++;
+	if(_u16_readPos >= _p_ready->_u16_length)
+	{
+		_p_ready = NULL;
+	}
+}
@@ -0,0 +1,106 @@
+/******************************************************************************
+ * @file    teleinfo_raw.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Raw teleinfo frames capture, from STX to ETX, in two static buffers :
+ * one is filled while the other one is read out in sequence numbered chunks
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_TELEINFO_RAW_H_
+#define TELEINFO_TELEINFO_RAW_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+class TeleinfoRawCapture {
+public:
+	/**
+	 * longest frame captured, STX and ETX included - longer frames are truncated.
+	 * Three-phase standard frames get close to 1KB. NB_BUFFERS frames are
+	 * allocated with capture object, raw mode enabled or not : 2KB of RAM
+	 */
+	static const uint16_t MAX_FRAME_LENGTH = 1024;
+	/** chunk header : frame sequence number, chunk index */
+	static const uint8_t CHUNK_HEADER_LENGTH = 2;
+	/** set in chunk index of last chunk of a frame */
+	static const uint8_t LAST_CHUNK_FLAG = 0x80;
+	/** set in chunk index of last chunk of a truncated frame */
+	static const uint8_t TRUNCATED_FLAG = 0x40;
+
+private:
+	static const uint8_t START_TEXT = 0x02;
+	static const uint8_t END_TEXT   = 0x03;
+	static const uint8_t NB_BUFFERS = 2;
+
+	struct FrameBuffer{
+		uint8_t _au8_bytes[MAX_FRAME_LENGTH];
+		uint16_t _u16_length;
+		bool _b_truncated;
+	};
+
+	FrameBuffer _buffers[NB_BUFFERS];
+	/** buffer being filled, NULL when waiting STX */
+	FrameBuffer* _p_filled;
+	/** complete frame being read out, NULL if none */
+	FrameBuffer* _p_ready;
+	/** read out position in ready frame */
+	uint16_t _u16_readPos;
+	uint8_t _u8_chunkIndex;
+	/** sequence number of next completed frame */
+	uint8_t _u8_frameSeq;
+	uint8_t _u8_readySeq;
+	/** max data bytes per chunk */
+	uint8_t _u8_chunkDataLength;
+
+	/** frames completed while previous one still read out */
+	uint32_t _u32_nbDroppedFrames;
+
+public:
+	/**
+	 * @param arg_u8_chunkLength max chunk length, header included
+	 */
+	TeleinfoRawCapture(uint8_t arg_u8_chunkLength);
+	~TeleinfoRawCapture(void){};
+
+	/**
+	 * Capture received bytes, parity bit cleared. Bytes outside STX ... ETX
+	 * are ignored
+	 */
+	void feed(const uint8_t* arg_au8_bytes, size_t arg_u32_nbBytes);
+
+	/**
+	 * Drop captured and ready frames
+	 */
+	void reset(void);
+
+	/**
+	 * Get next chunk of ready frame without consuming it
+	 * @param arg_au8_chunk filled with header then frame bytes
+	 * @return chunk length, 0 if no frame ready
+	 */
+	uint8_t peekChunk(uint8_t arg_au8_chunk[]) const;
+
+	/**
+	 * Consume chunk returned by peekChunk(), once sent
+	 */
+	void releaseChunk(void);
+
+	uint32_t getNbDroppedFrames(void) const {return _u32_nbDroppedFrames;};
+	void resetStats(void){_u32_nbDroppedFrames = 0;};
+};
+
+#endif /* TELEINFO_TELEINFO_RAW_H_ */
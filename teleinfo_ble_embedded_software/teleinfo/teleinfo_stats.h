@@ -0,0 +1,74 @@
+/******************************************************************************
+ * @file    teleinfo_stats.h
+ * @author  Rémi Pincent - INRIA
+ * @date    10 nov. 2015
+ *
+ * @brief Teleinfo parser health counters, always updated, used to spot
+ * degrading meter wiring
+ *
+ * Project : teleinfo_lib
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_TELEINFO_STATS_H_
+#define TELEINFO_TELEINFO_STATS_H_
+
+#include <stdint.h>
+
+/** min / avg / max of a measure */
+struct TeleinfoStatsRange{
+	uint32_t _u32_min;
+	uint32_t _u32_max;
+	uint64_t _u64_sum;
+	uint32_t _u32_count;
+
+	void add(uint32_t arg_u32_value)
+	{
+		if(_u32_count == 0 || arg_u32_value < _u32_min)
+		{
+			_u32_min = arg_u32_value;
+		}
+		if(arg_u32_value > _u32_max)
+		{
+			_u32_max = arg_u32_value;
+		}
+		_u64_sum += arg_u32_value;
+		_u32_count++;
+	};
+
+	uint32_t avg(void) const {return _u32_count ? (uint32_t)(_u64_sum / _u32_count) : 0;};
+};
+
+struct TeleinfoStats{
+	/** frames notified, partial ones included */
+	uint32_t _u32_nbFrames;
+	/** frames notified with some groups skipped */
+	uint32_t _u32_nbPartialFrames;
+	/** groups parsed */
+	uint32_t _u32_nbGroups;
+	/** groups with a valid CRC not handled by parser */
+	uint32_t _u32_nbUnhandledGroups;
+	uint32_t _u32_nbCRCErrors;
+	uint32_t _u32_nbLengthErrors;
+	uint32_t _u32_nbValueErrors;
+	/** unexpected bytes, invalid groups */
+	uint32_t _u32_nbReadErrors;
+	/** gaps between frames longer than Teleinfo::READ_TIMEOUT_MS */
+	uint32_t _u32_nbReadTimeouts;
+	/** time between ETX and next STX - ms */
+	TeleinfoStatsRange _frameGapMs;
+	/** time spent checking and parsing groups of a frame - us */
+	TeleinfoStatsRange _frameParseUs;
+};
+
+#endif /* TELEINFO_TELEINFO_STATS_H_ */
@@ -0,0 +1,191 @@
+/******************************************************************************
+ * @file    teleinfo_task.cpp
+ * @author  Rémi Pincent - INRIA
+ * @date    18 juin 2016
+ *
+ * @brief Application context task feeding teleinfo parser with received bytes
+ *
+ * Project : teleinfo_ble
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#include "teleinfo_task.h"
+#include <delay.h>
+#include "app_error.h"
+#include "nrf_soc.h"
+#include "logger.h"
+
+volatile bool TeleinfoTask::_sb_rxPending = false;
+volatile uint8_t TeleinfoTask::_su8_nbRxBytes = 0;
+
+TeleinfoTask::TeleinfoTask(UARTClass& arg_serial, Teleinfo& arg_teleinfo) :
+	_timer(this),
+	_p_serial(&arg_serial),
+	_p_stream(&arg_serial),
+	_p_teleinfo(&arg_teleinfo),
+	_p_rawCapture(NULL),
+	_u32_nbBudgetExhausted(0),
+	_b_lowPower(false),
+	_u32_nbWakeUps(0),
+	_u64_awakeUs(0),
+	_u64_wakeUpUs(0),
+	_u64_statsStartUs(0)
+{
+}
+
+void TeleinfoTask::start(bool arg_b_lowPower)
+{
+	_b_lowPower = arg_b_lowPower;
+	resetPowerStats();
+	if(_b_lowPower)
+	{
+		/** bytes received before start processed on first sleep() */
+		_sb_rxPending = true;
+		_p_serial->irq_attach(&onRxInterrupt);
+	}
+	else
+	{
+		_timer.notifyAfter(PERIOD_MS);
+	}
+}
+
+void TeleinfoTask::stop(void)
+{
+	if(_b_lowPower)
+	{
+		_p_serial->irq_attach(NULL);
+		_b_lowPower = false;
+	}
+	_timer.stop();
+}
+
+void TeleinfoTask::sleep(void)
+{
+	uint64_t loc_u64_nowUs;
+
+	if(!_b_lowPower)
+	{
+		return;
+	}
+
+	/**
+	 * Each received byte interrupt wakes CPU : sleep again while batch not
+	 * complete, return to application loop on any other event. No race with
+	 * RX interrupt : an interrupt occurring after test sets event register,
+	 * sd_app_evt_wait() then returns immediately
+	 */
+	while(!_sb_rxPending)
+	{
+		uint8_t loc_u8_nbRxBytes = _su8_nbRxBytes;
+
+		loc_u64_nowUs = micros64();
+		_u64_awakeUs += loc_u64_nowUs - _u64_wakeUpUs;
+		uint32_t loc_u32_err = sd_app_evt_wait();
+		APP_ERROR_CHECK(loc_u32_err);
+		_u64_wakeUpUs = micros64();
+		_u32_nbWakeUps++;
+
+		if(_su8_nbRxBytes == loc_u8_nbRxBytes)
+		{
+			/** not woken by a received byte */
+			break;
+		}
+	}
+
+	/** frame tail shorter than a batch processed on next wake up, timers included */
+	if(_sb_rxPending || _su8_nbRxBytes != 0)
+	{
+		_sb_rxPending = false;
+		_su8_nbRxBytes = 0;
+		if(!process())
+		{
+			/** do not sleep with bytes left */
+			_sb_rxPending = true;
+		}
+	}
+}
+
+TeleinfoTask::PowerStats TeleinfoTask::getPowerStats(void) const
+{
+	PowerStats loc_stats;
+	uint64_t loc_u64_nowUs = micros64();
+
+	loc_stats._u32_nbWakeUps = _u32_nbWakeUps;
+	/** currently awake */
+	loc_stats._u32_awakeMs = (uint32_t)((_u64_awakeUs + loc_u64_nowUs - _u64_wakeUpUs) / 1000);
+	loc_stats._u32_elapsedMs = (uint32_t)((loc_u64_nowUs - _u64_statsStartUs) / 1000);
+	return loc_stats;
+}
+
+void TeleinfoTask::resetPowerStats(void)
+{
+	_u32_nbWakeUps = 0;
+	_u64_awakeUs = 0;
+	_u64_statsStartUs = micros64();
+	_u64_wakeUpUs = _u64_statsStartUs;
+}
+
+void TeleinfoTask::setCaptureRecorder(TeleinfoCaptureRecorder* arg_p_recorder)
+{
+	/** RX interrupt still attached to UART : recorder only changes where bytes are read */
+	_p_stream = (arg_p_recorder != NULL) ? (Stream*) arg_p_recorder : (Stream*) _p_serial;
+}
+
+/** from TimerListener */
+void TeleinfoTask::timerElapsed(void)
+{
+	/** yield - let pending events run before going on */
+	_timer.notifyAfter(process() ? PERIOD_MS : YIELD_DELAY_MS);
+}
+
+bool TeleinfoTask::process(void)
+{
+	uint8_t loc_au8_bytes[READ_CHUNK_LENGTH];
+	uint8_t loc_u8_nbBytes;
+	uint16_t loc_u16_nbParsed = 0;
+	uint32_t loc_u32_startUs = micros();
+
+	while(_p_stream->available() > 0)
+	{
+		if(loc_u16_nbParsed >= MAX_BYTES_PER_TICK || micros() - loc_u32_startUs >= MAX_US_PER_TICK)
+		{
+			_u32_nbBudgetExhausted++;
+			return false;
+		}
+
+		for(loc_u8_nbBytes = 0; loc_u8_nbBytes < READ_CHUNK_LENGTH && _p_stream->available() > 0; loc_u8_nbBytes++)
+		{
+			loc_au8_bytes[loc_u8_nbBytes] = _p_stream->read();
+		}
+
+		if(_p_rawCapture != NULL)
+		{
+			_p_rawCapture->feed(loc_au8_bytes, loc_u8_nbBytes);
+		}
+		_p_teleinfo->feed(loc_au8_bytes, loc_u8_nbBytes);
+		loc_u16_nbParsed += loc_u8_nbBytes;
+	}
+	return true;
+}
+
+void TeleinfoTask::onRxInterrupt(void)
+{
+	if(_su8_nbRxBytes < RX_BATCH_LENGTH)
+	{
+		_su8_nbRxBytes++;
+	}
+	if(_su8_nbRxBytes >= RX_BATCH_LENGTH)
+	{
+		_sb_rxPending = true;
+	}
+}
@@ -0,0 +1,134 @@
+/******************************************************************************
+ * @file    teleinfo_task.h
+ * @author  Rémi Pincent - INRIA
+ * @date    18 juin 2016
+ *
+ * @brief Application context task feeding teleinfo parser with received bytes,
+ * bounded per tick so that BLE events and timers stay responsive. In low
+ * power mode, CPU sleeps until UART RX interrupt or any other event
+ *
+ * Project : teleinfo_ble
+ * Contact:  Rémi Pincent - remi.pincent@inria.fr
+ *
+ * Revision History:
+ * TODO_revision history
+ *
+ * LICENSE :
+ * teleinfo_ble (c) by Rémi Pincent
+ * teleinfo_ble is licensed under a
+ * Creative Commons Attribution-NonCommercial 3.0 Unported License.
+ *
+ * You should have received a copy of the license along with this
+ * work.  If not, see <http://creativecommons.org/licenses/by-nc/3.0/>.
+ *****************************************************************************/
+#ifndef TELEINFO_TASK_H_
+#define TELEINFO_TASK_H_
+
+/**************************************************************************
+ * Include Files
+ **************************************************************************/
+#include <Arduino.h>
+#include <EventManager.h>
+#include <timer.h>
+#include "teleinfo.h"
+#include "teleinfo_raw.h"
+#include "teleinfo_capture.h"
+
+class TeleinfoTask : public TimerListener
+{
+public:
+	/** low power mode current proxies since start or last resetPowerStats() */
+	struct PowerStats{
+		uint32_t _u32_nbWakeUps;
+		uint32_t _u32_awakeMs;
+		uint32_t _u32_elapsedMs;
+	};
+
+	/** UART buffer is 64 bytes - 66ms at standard mode baudrate */
+	static const uint32_t PERIOD_MS = 50;
+	/** delay before next tick when budget exhausted with bytes left */
+	static const uint32_t YIELD_DELAY_MS = 1;
+	/** max bytes parsed per tick */
+	static const uint16_t MAX_BYTES_PER_TICK = 128;
+	/** max time spent per tick - checked every READ_CHUNK_LENGTH bytes */
+	static const uint32_t MAX_US_PER_TICK = 2000;
+	/**
+	 * low power mode : received bytes processed once this many are pending,
+	 * or on any other wake up. Half of UART buffer - 33ms left at standard
+	 * mode baudrate before overrun
+	 */
+	static const uint8_t RX_BATCH_LENGTH = 32;
+
+private:
+	/** bytes read from stream at once */
+	static const uint8_t READ_CHUNK_LENGTH = 32;
+
+	Timer _timer;
+	UARTClass* _p_serial;
+	/** bytes read from it - _p_serial or a capture recorder wrapping it */
+	Stream* _p_stream;
+	Teleinfo* _p_teleinfo;
+	/** bytes also captured when not NULL */
+	TeleinfoRawCapture* _p_rawCapture;
+	/** ticks ended on budget with bytes left */
+	uint32_t _u32_nbBudgetExhausted;
+
+	/** set from UART RX interrupt once RX_BATCH_LENGTH bytes received */
+	static volatile bool _sb_rxPending;
+	/** bytes received since last process() */
+	static volatile uint8_t _su8_nbRxBytes;
+	bool _b_lowPower;
+	uint32_t _u32_nbWakeUps;
+	uint64_t _u64_awakeUs;
+	uint64_t _u64_wakeUpUs;
+	uint64_t _u64_statsStartUs;
+
+public:
+	TeleinfoTask(UARTClass& arg_serial, Teleinfo& arg_teleinfo);
+	~TeleinfoTask(void){};
+
+	/**
+	 * @param arg_b_lowPower true to process bytes on RX interrupt from
+	 * sleep(), false to poll stream every PERIOD_MS
+	 */
+	void start(bool arg_b_lowPower);
+	void stop(void);
+
+	/**
+	 * In low power mode, sleep until an event other than a received byte, or
+	 * until RX_BATCH_LENGTH bytes received, then process received bytes. Must
+	 * be called from application loop
+	 */
+	void sleep(void);
+
+	PowerStats getPowerStats(void) const;
+	void resetPowerStats(void);
+
+	/**
+	 * @param arg_p_rawCapture received bytes also given to it, NULL to stop
+	 */
+	void setRawCapture(TeleinfoRawCapture* arg_p_rawCapture){_p_rawCapture = arg_p_rawCapture;};
+
+	/**
+	 * @param arg_p_recorder recorder wrapping task UART, bytes then read
+	 * through it and recorded. NULL to read UART directly
+	 */
+	void setCaptureRecorder(TeleinfoCaptureRecorder* arg_p_recorder);
+
+	uint32_t getNbBudgetExhausted(void) const {return _u32_nbBudgetExhausted;};
+
+private:
+	/** from TimerListener */
+	void timerElapsed(void);
+
+	/**
+	 * Feed parser with received bytes within tick budget
+	 * @return false if budget exhausted with bytes left
+	 */
+	bool process(void);
+
+	/** UART RX interrupt callback */
+	static void onRxInterrupt(void);
+};
+
+#endif /* TELEINFO_TASK_H_ */
@@ -8,11 +8,141 @@ var influx = require('influx');
  *************************************************/
 var teleinfoBleNode = null;
 
+/** teleinfoBleNode health counters period */
+var STATS_PERIOD_MS = 15 * 60 * 1000;
+var statsTimer = null;
+
 var TeleinfoTypes = Object.freeze({
   IINST : 0,
-  APP_POWER : 1
+  APP_POWER : 1,
+  STATS : 2,
+  AGGREGATE : 3,
+  RAW_FRAME : 4,
+  FRAME_RECORD : 5,
+  INDEX_RECORD : 6,
+  SNAPSHOT : 7,
+  ACK : 8
+});
+
+/**
+ * SNAPSHOT entries by teleinfoBleNode ETeleinfoField : name, value length -
+ * 0 for [length][chars] strings. char : single char value stored as a letter.
+ * phases : one value per phase, stored as name1, name2, name3
+ */
+var SnapshotFields = Object.freeze({
+  0 : {name : 'adco', length : 0},
+  1 : {name : 'optarif', length : 1},
+  2 : {name : 'index_base', length : 4},
+  3 : {name : 'index_hchc', length : 4},
+  4 : {name : 'index_hchp', length : 4},
+  5 : {name : 'index_ejphn', length : 4},
+  6 : {name : 'index_ejphpm', length : 4},
+  7 : {name : 'pejp', length : 1},
+  8 : {name : 'gaz', length : 4},
+  9 : {name : 'ptec', length : 1},
+  10 : {name : 'motdetat', length : 0},
+  11 : {name : 'iinst', length : 2},
+  12 : {name : 'imax', length : 2},
+  13 : {name : 'isousc', length : 2},
+  14 : {name : 'app_power', length : 4},
+  15 : {name : 'hhphc', length : 1, char : true},
+  16 : {name : 'iinst', length : 2, phases : 3},
+  17 : {name : 'imax', length : 2, phases : 3},
+  18 : {name : 'adir', length : 2, phases : 3},
+  19 : {name : 'pmax', length : 4},
+  20 : {name : 'ppot', length : 1},
+  21 : {name : 'index_bbrhcjb', length : 4},
+  22 : {name : 'index_bbrhpjb', length : 4},
+  23 : {name : 'index_bbrhcjw', length : 4},
+  24 : {name : 'index_bbrhpjw', length : 4},
+  25 : {name : 'index_bbrhcjr', length : 4},
+  26 : {name : 'index_bbrhpjr', length : 4},
+  27 : {name : 'demain', length : 1},
+  28 : {name : 'ngtf', length : 0},
+  29 : {name : 'ltarf', length : 0},
+  30 : {name : 'ntarf', length : 1},
+  31 : {name : 'pref', length : 1},
+  32 : {name : 'urms1', length : 2},
+  33 : {name : 'stge', length : 4}
+});
+var SNAPSHOT_LAST_PART = 0x80;
+
+/** INDEX_RECORD presence bit n gives index n */
+var IndexNames = Object.freeze(['base', 'hchc', 'hchp', 'ejphn', 'ejphpm',
+  'bbrhcjb', 'bbrhpjb', 'bbrhcjw', 'bbrhpjw', 'bbrhcjr', 'bbrhpjr']);
+var INDEX_KEYFRAME_FLAG = 0x8000;
+/** reconstructed indexes, null until received in a keyframe */
+var indexValues = IndexNames.map(function(){ return null; });
+var lastIndexSeq = null;
+
+/** FRAME_RECORD versions handled */
+var FRAME_RECORD_VERSION = 1;
+/** FRAME_RECORD fields in packing order : presence bit, name, length */
+var RecordFields = Object.freeze([
+  {bit : 0x01, name : 'iinst', length : 2},
+  {bit : 0x02, name : 'app_power', length : 3},
+  {bit : 0x04, name : 'real_power', length : 3},
+  {bit : 0x08, name : 'ptec', length : 1},
+  {bit : 0x10, name : 'isousc', length : 1},
+  {bit : 0x20, name : 'demain', length : 1}
+]);
+var lastRecordSeq = null;
+/** device millis() and reception time of record records are timed from */
+var recordClock = null;
+
+/** commands written to teleinfoBleNode */
+var TeleinfoCommands = Object.freeze({
+  DUMP_STATS : 0,
+  RESET_STATS : 1,
+  SET_RAW_MODE : 2,
+  REQUEST_KEYFRAME : 3,
+  REQUEST_SNAPSHOT : 4,
+  SET_RECORD_FIELDS : 5,
+  SET_DEADBAND : 6,
+  SET_AGGREGATE_WINDOW : 7,
+  SET_PERIOD : 8
 });
 
+/** ACK status names, in status order */
+var AckStatus = Object.freeze(['ok', 'unknown command', 'bad length', 'bad value']);
+
+/** raw frame chunk index flags */
+var RAW_LAST_CHUNK = 0x80;
+var RAW_TRUNCATED = 0x40;
+/** raw frame being reassembled */
+var rawFrame = null;
+var lastRawFrameSeq = null;
+
+/** names of big endian uint32 values in each stats part */
+var StatsParts = Object.freeze([
+  ['nb_frames', 'nb_partial_frames', 'nb_groups', 'nb_unhandled_groups'],
+  ['nb_crc_errors', 'nb_length_errors', 'nb_value_errors', 'nb_read_errors'],
+  ['nb_read_timeouts', 'nb_uart_overruns', 'nb_uart_errors'],
+  ['frame_gap_min_ms', 'frame_gap_avg_ms', 'frame_gap_max_ms'],
+  ['frame_parse_min_us', 'frame_parse_avg_us', 'frame_parse_max_us'],
+  ['nb_wake_ups', 'awake_ms', 'elapsed_ms', 'nb_budget_exhausted'],
+  ['nb_queued', 'nb_coalesced', 'nb_dropped', 'queue_max_depth'],
+  ['nb_raw_dropped_frames']
+]);
+
+/** teleinfoBleNode aggregation windows names, in window index order - updated on SET_AGGREGATE_WINDOW ack */
+var AggregateWindows = ['10s', '1min', '15min'];
+
+/**
+ * teleinfoBleNode configuration sent on connection, defaults kept when not set :
+ * RECORD_FIELDS=iinst,app_power,... FRAME_RECORD fields
+ * DEADBANDS=app_power:absolute:perMille:minIntervalS:refreshS,... snapshot field names
+ * AGGREGATE_WINDOWS=10,60,900 windows durations in s
+ * PERIOD_MS=2000 teleinfoBleNode timer period
+ */
+var recordFieldsConfig = process.env.RECORD_FIELDS;
+var deadbandsConfig = process.env.DEADBANDS;
+var aggregateWindowsConfig = process.env.AGGREGATE_WINDOWS;
+var periodMsConfig = process.env.PERIOD_MS;
+
+/** set RAW_FRAMES to get meter frames as received by teleinfoBleNode */
+var rawFramesEnabled = (process.env.RAW_FRAMES !== undefined);
+
 if(process.env.DB){
   var db = process.env.DB;
 }
@@ -110,6 +240,9 @@ function connectTeleinfoNode(fctCallback){
       debug('connect to teleinfoBleNode');
       teleinfoBleNode.connect(function () {
         debug('connected to teleinfoBleNode');
+        /** node may have restarted : sequence and millis() restarted */
+        lastRecordSeq = null;
+        recordClock = null;
         callback();
       });
     },
@@ -152,6 +285,15 @@ function connectTeleinfoNode(fctCallback){
       });
       teleinfoBleNode.notifyDataReceive(function () {
         debug('you will be notified on new data');
+        if(statsTimer === null){
+          statsTimer = setInterval(requestStats, STATS_PERIOD_MS);
+        }
+        configureTeleinfoNode();
+        if(rawFramesEnabled){
+          teleinfoBleNode.writeData(new Buffer([TeleinfoCommands.SET_RAW_MODE, 1]), function(){
+            debug('raw frames requested');
+          });
+        }
         callback();
       });
     }
@@ -179,6 +321,40 @@ function onDataReceived(data, callback){
       var appPower = data.readUInt32BE(1);
       debug('APPPOWER=' + appPower + 'W');
       toDB('teleinfo_app_power', appPower, callback);
+      /** real power estimate follows, 0xFFFFFFFF until estimated */
+      if(data.length >= 9 && data.readUInt32BE(5) !== 0xFFFFFFFF){
+        var realPower = data.readUInt32BE(5);
+        debug('REALPOWER=' + realPower + 'W');
+        toDB('teleinfo_real_power', realPower, callback);
+      }
+      break;
+
+    case TeleinfoTypes.STATS:
+      onStatsReceived(data, callback);
+      break;
+
+    case TeleinfoTypes.AGGREGATE:
+      onAggregateReceived(data, callback);
+      break;
+
+    case TeleinfoTypes.RAW_FRAME:
+      onRawChunkReceived(data, callback);
+      break;
+
+    case TeleinfoTypes.FRAME_RECORD:
+      onFrameRecordReceived(data, callback);
+      break;
+
+    case TeleinfoTypes.INDEX_RECORD:
+      onIndexRecordReceived(data, callback);
+      break;
+
+    case TeleinfoTypes.SNAPSHOT:
+      onSnapshotReceived(data, callback);
+      break;
+
+    case TeleinfoTypes.ACK:
+      onAckReceived(data);
       break;
       
     default:
@@ -186,6 +362,341 @@ function onDataReceived(data, callback){
   }
 }
 
+function onStatsReceived(data, callback){
+  var names = StatsParts[data[1]];
+  if(names === undefined){
+    debug('stats part ' + data[1] + ' not handled');
+    return;
+  }
+
+  for(var index = 0; index < names.length && 2 + 4 * (index + 1) <= data.length; index++){
+    var value = data.readUInt32BE(2 + 4 * index);
+    debug('STATS ' + names[index] + '=' + value);
+    toDB('teleinfo_stats_' + names[index], value, callback);
+  }
+}
+
+function onAggregateReceived(data, callback){
+  var window = AggregateWindows[data[1]];
+  if(window === undefined){
+    debug('aggregate window ' + data[1] + ' not handled');
+    return;
+  }
+
+  var values = {
+    app_power_min : data.readUIntBE(2, 3),
+    app_power_mean : data.readUIntBE(5, 3),
+    app_power_max : data.readUIntBE(8, 3),
+    iinst_min : data.readUInt16BE(11),
+    iinst_mean : data.readUInt16BE(13),
+    iinst_max : data.readUInt16BE(15),
+    energy_wh : data.readUInt16BE(17)
+  };
+  for(var name in values){
+    debug('AGGREGATE ' + window + ' ' + name + '=' + values[name]);
+    toDB('teleinfo_' + name + '_' + window, values[name], callback);
+  }
+}
+
+/** [FRAME_RECORD][version][sequence][timestamp ms - 32 bits][presence][values] */
+function onFrameRecordReceived(data, callback){
+  if(data[1] !== FRAME_RECORD_VERSION){
+    debug('frame record version ' + data[1] + ' not handled');
+    return;
+  }
+
+  var seq = data[2];
+  if(lastRecordSeq !== null && seq !== ((lastRecordSeq + 1) & 0xFF)){
+    debug(((seq - lastRecordSeq - 1) & 0xFF) + ' frame records lost');
+  }
+  lastRecordSeq = seq;
+
+  var timestamp = data.readUInt32BE(3);
+  var time = recordTime(timestamp);
+  var presence = data[7];
+  var offset = 8;
+  RecordFields.forEach(function(field){
+    if(!(presence & field.bit)){
+      return;
+    }
+    if(offset + field.length > data.length){
+      debug('frame record ' + seq + ' truncated');
+      offset = data.length;
+      return;
+    }
+    var value = data.readUIntBE(offset, field.length);
+    offset += field.length;
+    debug('RECORD ' + seq + '@' + timestamp + 'ms ' + field.name + '=' + value);
+    toDB('teleinfo_' + field.name, value, callback, time);
+  });
+}
+
+/**
+ * Map a record device timestamp to a date : records are timed relative to
+ * latest record, received right away. A record queued on node gets its
+ * frame time. Reference moves to a record that would otherwise be in the
+ * future so that clocks drift is not accumulated
+ * @param deviceMs node millis() when frame received - wraps on 32 bits
+ */
+function recordTime(deviceMs){
+  var now = Date.now();
+  if(recordClock !== null){
+    /** signed 32 bits difference - millis() wraps */
+    var time = recordClock.hostMs + ((deviceMs - recordClock.deviceMs) | 0);
+    if(time <= now){
+      return new Date(time);
+    }
+  }
+  recordClock = {deviceMs : deviceMs, hostMs : now};
+  return new Date(now);
+}
+
+/** [SNAPSHOT][part | last][entries : field, age s - 16 bits, value] */
+function onSnapshotReceived(data, callback){
+  var part = data[1] & ~SNAPSHOT_LAST_PART;
+  var offset = 2;
+
+  while(offset + 3 <= data.length){
+    var field = SnapshotFields[data[offset]];
+    var age = data.readUInt16BE(offset + 1);
+    var value;
+    offset += 3;
+    if(field === undefined){
+      debug('snapshot field ' + data[offset - 3] + ' not handled - part ' + part + ' dropped');
+      return;
+    }
+    if(field.length === 0){
+      value = data.toString('binary', offset + 1, offset + 1 + data[offset]);
+      offset += 1 + data[offset];
+    }
+    else if(field.phases){
+      for(var phase = 1; phase <= field.phases; phase++){
+        value = data.readUIntBE(offset, field.length);
+        offset += field.length;
+        debug('SNAPSHOT ' + field.name + phase + '=' + value + ' - ' + age + 's old');
+        toDB('teleinfo_' + field.name + phase, value, callback, new Date(Date.now() - age * 1000));
+      }
+      continue;
+    }
+    else{
+      value = data.readUIntBE(offset, field.length);
+      offset += field.length;
+      if(field.char){
+        value = String.fromCharCode(value);
+      }
+    }
+    debug('SNAPSHOT ' + field.name + '=' + value + ' - ' + age + 's old');
+    toDB('teleinfo_' + field.name, value, callback, new Date(Date.now() - age * 1000));
+  }
+
+  if(data[1] & SNAPSHOT_LAST_PART){
+    debug('snapshot complete');
+  }
+}
+
+/**
+ * [INDEX_RECORD][sequence][presence - 16 bits][values] : uint32 in keyframes,
+ * zigzag varint deltas otherwise
+ */
+function onIndexRecordReceived(data, callback){
+  var seq = data[1];
+  var mask = data.readUInt16BE(2);
+  var keyframe = (mask & INDEX_KEYFRAME_FLAG) !== 0;
+  var offset = 4;
+
+  /** deltas of lost record missing - wait for absolute values */
+  if(lastIndexSeq !== null && seq !== ((lastIndexSeq + 1) & 0xFF)){
+    debug(((seq - lastIndexSeq - 1) & 0xFF) + ' index records lost - keyframe requested');
+    indexValues = IndexNames.map(function(){ return null; });
+    requestKeyframe();
+  }
+  lastIndexSeq = seq;
+
+  for(var index = 0; index < IndexNames.length; index++){
+    if(!(mask & (1 << index))){
+      continue;
+    }
+    var value;
+    if(keyframe){
+      value = data.readUInt32BE(offset);
+      offset += 4;
+    }
+    else{
+      var zigzag = 0;
+      var shift = 0;
+      var byte;
+      do{
+        byte = data[offset++];
+        zigzag += (byte & 0x7F) * Math.pow(2, shift);
+        shift += 7;
+      }while(byte & 0x80);
+      var delta = (zigzag % 2) ? -(zigzag + 1) / 2 : zigzag / 2;
+      if(indexValues[index] === null){
+        continue;
+      }
+      value = indexValues[index] + delta;
+    }
+    indexValues[index] = value;
+    debug('INDEX ' + IndexNames[index] + '=' + value + 'Wh');
+    toDB('teleinfo_index_' + IndexNames[index], value, callback);
+  }
+}
+
+function requestKeyframe(){
+  if(teleinfoBleNode === null){
+    return;
+  }
+  teleinfoBleNode.writeData(new Buffer([TeleinfoCommands.REQUEST_KEYFRAME]), function(){
+    debug('index keyframe requested');
+  });
+}
+
+/** [RAW_FRAME][frame sequence][chunk index | flags][frame bytes] */
+function onRawChunkReceived(data, callback){
+  var seq = data[1];
+  var index = data[2] & ~(RAW_LAST_CHUNK | RAW_TRUNCATED);
+
+  if(index === 0){
+    if(rawFrame !== null){
+      debug('raw frame ' + rawFrame.seq + ' incomplete - dropped');
+    }
+    rawFrame = {seq : seq, nextIndex : 0, chunks : []};
+  }
+  if(rawFrame === null || rawFrame.seq !== seq || rawFrame.nextIndex !== index){
+    debug('raw frame ' + seq + ' chunk ' + index + ' out of sequence - dropped');
+    rawFrame = null;
+    return;
+  }
+
+  rawFrame.chunks.push(data.slice(3));
+  rawFrame.nextIndex++;
+  if(!(data[2] & RAW_LAST_CHUNK)){
+    return;
+  }
+
+  if(lastRawFrameSeq !== null && seq !== ((lastRawFrameSeq + 1) & 0xFF)){
+    debug(((seq - lastRawFrameSeq - 1) & 0xFF) + ' raw frames lost');
+  }
+  lastRawFrameSeq = seq;
+  if(data[2] & RAW_TRUNCATED){
+    debug('raw frame ' + seq + ' truncated');
+  }
+  var frame = Buffer.concat(rawFrame.chunks).toString('binary');
+  rawFrame = null;
+  debug('RAW_FRAME ' + JSON.stringify(frame));
+  toDB('teleinfo_raw_frame', frame, callback);
+}
+
+/** @return window name from its duration in s */
+function windowName(durationS){
+  if(durationS % 3600 === 0){
+    return (durationS / 3600) + 'h';
+  }
+  if(durationS % 60 === 0){
+    return (durationS / 60) + 'min';
+  }
+  return durationS + 's';
+}
+
+/** @return ETeleinfoField id of given snapshot field name, undefined if unknown */
+function teleinfoFieldId(name){
+  for(var id in SnapshotFields){
+    if(SnapshotFields[id].name === name){
+      return Number(id);
+    }
+  }
+  return undefined;
+}
+
+/** @return configuration commands built from environment variables */
+function configurationCommands(){
+  var commands = [];
+
+  if(recordFieldsConfig !== undefined){
+    var bits = 0;
+    recordFieldsConfig.split(',').forEach(function(name){
+      var field = RecordFields.filter(function(recordField){ return recordField.name === name; })[0];
+      if(field === undefined){
+        debug('record field ' + name + ' unknown - ignored');
+        return;
+      }
+      bits |= field.bit;
+    });
+    commands.push(new Buffer([TeleinfoCommands.SET_RECORD_FIELDS, bits]));
+  }
+
+  if(deadbandsConfig !== undefined){
+    deadbandsConfig.split(',').forEach(function(deadband){
+      var values = deadband.split(':');
+      var id = teleinfoFieldId(values[0]);
+      if(id === undefined || values.length !== 5){
+        debug('deadband ' + deadband + ' invalid - ignored');
+        return;
+      }
+      var command = new Buffer(10);
+      command[0] = TeleinfoCommands.SET_DEADBAND;
+      command[1] = id;
+      for(var index = 1; index < 5; index++){
+        command.writeUInt16BE(Number(values[index]), 2 * index);
+      }
+      commands.push(command);
+    });
+  }
+
+  if(aggregateWindowsConfig !== undefined){
+    aggregateWindowsConfig.split(',').forEach(function(durationS, window){
+      var command = new Buffer(6);
+      command[0] = TeleinfoCommands.SET_AGGREGATE_WINDOW;
+      command[1] = window;
+      command.writeUInt32BE(Number(durationS), 2);
+      commands.push(command);
+    });
+  }
+
+  if(periodMsConfig !== undefined){
+    var command = new Buffer(3);
+    command[0] = TeleinfoCommands.SET_PERIOD;
+    command.writeUInt16BE(Number(periodMsConfig), 1);
+    commands.push(command);
+  }
+  return commands;
+}
+
+/** send configuration given in environment - applied until teleinfoBleNode reset */
+function configureTeleinfoNode(){
+  configurationCommands().forEach(function(command){
+    teleinfoBleNode.writeData(command, function(){
+      debug('command ' + command.toString('hex') + ' sent');
+    });
+  });
+}
+
+/** [ACK][status][command bytes] */
+function onAckReceived(data){
+  var status = AckStatus[data[1]] || ('status ' + data[1]);
+  var command = data.slice(2);
+
+  if(data[1] !== 0){
+    debug('command ' + command.toString('hex') + ' failed : ' + status);
+    return;
+  }
+  debug('command ' + command.toString('hex') + ' ok');
+  if(command[0] === TeleinfoCommands.SET_AGGREGATE_WINDOW && command.length === 6){
+    AggregateWindows[command[1]] = windowName(command.readUInt32BE(2));
+    debug('aggregate window ' + command[1] + ' is now ' + AggregateWindows[command[1]]);
+  }
+}
+
+/** ask teleinfoBleNode for its parser and link health counters */
+function requestStats(){
+  if(teleinfoBleNode === null){
+    return;
+  }
+  teleinfoBleNode.writeData(new Buffer([TeleinfoCommands.DUMP_STATS]), function(){
+    debug('stats requested');
+  });
+}
+
 function openDB(callback){
   var nbConnectTries = 10;
 
@@ -247,9 +758,10 @@ function createDb(dbNames, callback)
 };
 
 
-function toDB(field, fieldValue, callback)
+/** @param time optional - now if not given */
+function toDB(field, fieldValue, callback, time)
 {
-  dbClient.writePoint(field, {time: new Date(), value: fieldValue}, null, function(err, response) { 
+  dbClient.writePoint(field, {time: time || new Date(), value: fieldValue}, null, function(err, response) { 
     if(err)
     {
       debug("Cannot write to db : " + err);